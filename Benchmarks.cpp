@@ -0,0 +1,638 @@
+// Micro-benchmarks for the curve math, built on Google Benchmark.
+//
+// Only needs the CurveMath library, so it builds anywhere that does. For JSON results to compare between builds:
+//   Benchmarks --benchmark_out=results.json --benchmark_out_format=json
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+
+#include "CurveEvaluation.hpp"
+#include "CurveMath.hpp"
+
+// Control point counts from the smallest curve the UI allows to well past
+// the largest, and sample counts from a coarse curve to a dense one.
+static const std::vector<int64_t> cControlPoints = { 2, 10, 100, 1000, 10000, 100000 };
+static const std::vector<int64_t> cSamples = { 64, 1024 };
+
+// Keeps the slower sweeps from spending minutes on a single configuration.
+constexpr double cWorkBudget = 2e9;
+
+static std::vector<float> RandomControlPoints(size_t aCount)
+{
+  std::mt19937 generator{ 300 };
+  std::uniform_real_distribution<float> distribution{ -3.0f, 3.0f };
+
+  std::vector<float> points(aCount);
+
+  for (auto &point : points)
+  {
+    point = distribution(generator);
+  }
+
+  return points;
+}
+
+static BezierControlPolygon RandomPolygon(size_t aCount, bool a3D)
+{
+  std::mt19937 generator{ 300 };
+  std::uniform_real_distribution<float> distribution{ -3.0f, 3.0f };
+
+  BezierControlPolygon polygon;
+
+  for (size_t i{ 0 }; i < aCount; ++i)
+  {
+    polygon.mX.push_back(distribution(generator));
+    polygon.mY.push_back(distribution(generator));
+
+    if (a3D)
+    {
+      polygon.mZ.push_back(distribution(generator));
+    }
+  }
+
+  return polygon;
+}
+
+// Every control point count with every sample count, skipping the ones where
+// aCost(points, samples) is over the budget.
+template <typename Cost>
+static void ControlPointsBySamples(benchmark::internal::Benchmark *aBenchmark, Cost aCost)
+{
+  aBenchmark->ArgNames({ "points", "samples" });
+
+  for (auto points : cControlPoints)
+  {
+    for (auto samples : cSamples)
+    {
+      if (aCost(static_cast<double>(points), static_cast<double>(samples)) <= cWorkBudget)
+      {
+        aBenchmark->Args({ points, samples });
+      }
+    }
+  }
+}
+
+static void LinearArgs(benchmark::internal::Benchmark *aBenchmark)
+{
+  ControlPointsBySamples(aBenchmark, [](double aPoints, double aSamples) { return aPoints * aSamples; });
+}
+
+static void QuadraticArgs(benchmark::internal::Benchmark *aBenchmark)
+{
+  ControlPointsBySamples(aBenchmark, [](double aPoints, double aSamples) { return aPoints * aPoints * aSamples; });
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Scalar helpers
+///////////////////////////////////////////////////////////////////////////////////
+static void BM_Factorial(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+
+  for (auto _ : aState)
+  {
+    benchmark::DoNotOptimize(factorial(n));
+  }
+}
+// factorial overflows size_t past 20.
+BENCHMARK(BM_Factorial)->ArgName("n")->Arg(2)->Arg(10)->Arg(20);
+
+static void BM_BernstienPolynomial(benchmark::State &aState)
+{
+  auto d = static_cast<size_t>(aState.range(0) - 1);
+
+  for (auto _ : aState)
+  {
+    benchmark::DoNotOptimize(BernstienPolynomial(d, d / 2, 0.37f));
+  }
+}
+BENCHMARK(BM_BernstienPolynomial)->ArgName("points")->Arg(2)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000)->Arg(100000);
+
+///////////////////////////////////////////////////////////////////////////////////
+// Project 1 evaluation
+///////////////////////////////////////////////////////////////////////////////////
+
+// What P1_BB_GetPoint does for each sample.
+static void BM_BernsteinBasis(benchmark::State &aState)
+{
+  auto points = RandomControlPoints(static_cast<size_t>(aState.range(0)));
+  std::vector<float> ts;
+  UniformSamples(static_cast<size_t>(aState.range(1)), ts);
+
+  BernsteinBasis basis;
+  basis.SetDegree(points.size() - 1);
+
+  for (auto _ : aState)
+  {
+    for (auto t : ts)
+    {
+      benchmark::DoNotOptimize(basis.Evaluate(points.data(), t));
+    }
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * ts.size());
+}
+BENCHMARK(BM_BernsteinBasis)->Apply(LinearArgs);
+
+// What the NLI sampler does for each batch of samples.
+static void BM_DeCasteljau(benchmark::State &aState, SimdLevel aLevel)
+{
+  auto points = RandomControlPoints(static_cast<size_t>(aState.range(0)));
+  std::vector<float> ts;
+  UniformSamples(static_cast<size_t>(aState.range(1)), ts);
+
+  std::vector<float> ys(ts.size());
+  std::vector<float> scratch;
+
+  if (static_cast<int>(aLevel) > static_cast<int>(DetectSimdLevel()))
+  {
+    aState.SkipWithError("Not supported by this CPU.");
+    return;
+  }
+
+  for (auto _ : aState)
+  {
+    EvaluateDeCasteljau(points.data(), points.size(), ts.data(), ys.data(), ts.size(), scratch, aLevel);
+    benchmark::DoNotOptimize(ys.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * ts.size());
+  aState.SetLabel(ToString(aLevel));
+}
+BENCHMARK_CAPTURE(BM_DeCasteljau, Scalar, SimdLevel::Scalar)->Apply(QuadraticArgs);
+BENCHMARK_CAPTURE(BM_DeCasteljau, SSE2, SimdLevel::SSE2)->Apply(QuadraticArgs);
+BENCHMARK_CAPTURE(BM_DeCasteljau, AVX2, SimdLevel::AVX2)->Apply(QuadraticArgs);
+BENCHMARK_CAPTURE(BM_DeCasteljau, AVX512, SimdLevel::AVX512)->Apply(QuadraticArgs);
+
+// Full adaptive tessellation of the BB curve, as Project 1 draws it.
+static void BM_TessellateBB(benchmark::State &aState)
+{
+  auto points = RandomControlPoints(static_cast<size_t>(aState.range(0)));
+
+  BernsteinBasis basis;
+  basis.SetDegree(points.size() - 1);
+
+  CurveSampler sampler = [&](const float *aTs, float *aYs, size_t aCount)
+  {
+    for (size_t i{ 0 }; i < aCount; ++i)
+    {
+      aYs[i] = basis.Evaluate(points.data(), aTs[i]);
+    }
+  };
+
+  // Roughly the default camera, looking at the curve across a 720p window.
+  ScreenMapping mapping{ glm::mat4{ 1.0f }, { 1280.0f, 720.0f }, 0.5f };
+  mapping.mModelViewProjection[0][0] = 1.8f;
+  mapping.mModelViewProjection[3][0] = -0.9f;
+  mapping.mModelViewProjection[1][1] = 0.3f;
+
+  AdaptiveTessellator tessellator;
+  std::vector<glm::vec2> curve;
+
+  for (auto _ : aState)
+  {
+    tessellator.Tessellate(sampler, mapping, curve);
+    benchmark::DoNotOptimize(curve.data());
+  }
+
+  aState.counters["vertices"] = static_cast<double>(curve.size());
+}
+BENCHMARK(BM_TessellateBB)->ArgName("points")->Arg(2)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// One dense curve split across a growing number of threads, items_per_second
+// is samples per second.
+static void BM_SamplePolynomialParallel(benchmark::State &aState, PolynomialMethod aMethod)
+{
+  static ThreadPool pool;
+
+  auto threads = static_cast<size_t>(aState.range(0));
+
+  if (threads > pool.WorkerCount() + 1)
+  {
+    aState.SkipWithError("More threads than this machine has.");
+    return;
+  }
+
+  auto points = RandomControlPoints(100);
+  std::vector<float> ts;
+  UniformSamples(1000000, ts);
+  std::vector<float> ys(ts.size());
+
+  for (auto _ : aState)
+  {
+    SamplePolynomial(aMethod, points, ts.data(), ys.data(), ts.size(), &pool, threads);
+    benchmark::DoNotOptimize(ys.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * ts.size());
+}
+BENCHMARK_CAPTURE(BM_SamplePolynomialParallel, NLI, PolynomialMethod::NLI)
+  ->ArgName("threads")->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK_CAPTURE(BM_SamplePolynomialParallel, BB, PolynomialMethod::BB)
+  ->ArgName("threads")->RangeMultiplier(2)->Range(1, 64)->UseRealTime()->Unit(benchmark::kMillisecond);
+
+// Dense, evenly spaced sampling of low degree curves, where forward
+// differencing competes. max_error is against the curve evaluated in double.
+static void BM_UniformSamples(benchmark::State &aState, PolynomialMethod aMethod)
+{
+  auto points = RandomControlPoints(static_cast<size_t>(aState.range(0)));
+  auto count = static_cast<size_t>(aState.range(1));
+
+  std::vector<float> ts;
+  UniformSamples(count, ts);
+  std::vector<float> ys(count);
+
+  for (auto _ : aState)
+  {
+    if (PolynomialMethod::FD == aMethod)
+    {
+      SampleUniformPolynomial(points, ys.data(), count);
+    }
+    else
+    {
+      SamplePolynomial(aMethod, points, ts.data(), ys.data(), count);
+    }
+
+    benchmark::DoNotOptimize(ys.data());
+  }
+
+  double maxError{ 0.0 };
+  std::vector<double> row(points.size());
+
+  for (size_t i{ 0 }; i < count; ++i)
+  {
+    double t = static_cast<double>(i) / (count - 1);
+    std::copy(points.begin(), points.end(), row.begin());
+
+    for (size_t k{ 1 }; k < row.size(); ++k)
+    {
+      for (size_t j{ 0 }; j < row.size() - k; ++j)
+      {
+        row[j] = (1.0 - t) * row[j] + t * row[j + 1];
+      }
+    }
+
+    maxError = std::max(maxError, std::abs(ys[i] - row[0]));
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * count);
+  aState.counters["max_error"] = maxError;
+}
+
+static void UniformArgs(benchmark::internal::Benchmark *aBenchmark, int aMaxPoints)
+{
+  aBenchmark->ArgNames({ "points", "samples" });
+
+  for (auto points : { 2, 3, 4, 5, 8, 16, 64 })
+  {
+    for (auto samples : { 1024, 65536 })
+    {
+      if (points <= aMaxPoints)
+      {
+        aBenchmark->Args({ points, samples });
+      }
+    }
+  }
+}
+
+static void UniformArgs(benchmark::internal::Benchmark *aBenchmark)
+{
+  UniformArgs(aBenchmark, std::numeric_limits<int>::max());
+}
+
+// Past cForwardDifferenceMaxDegree SampleUniformPolynomial runs de Casteljau,
+// so those rows would just be NLI again under FD's name.
+static void ForwardDifferenceArgs(benchmark::internal::Benchmark *aBenchmark)
+{
+  UniformArgs(aBenchmark, static_cast<int>(cForwardDifferenceMaxDegree + 1));
+}
+BENCHMARK_CAPTURE(BM_UniformSamples, NLI, PolynomialMethod::NLI)->Apply(UniformArgs);
+BENCHMARK_CAPTURE(BM_UniformSamples, BB, PolynomialMethod::BB)->Apply(UniformArgs);
+BENCHMARK_CAPTURE(BM_UniformSamples, FD, PolynomialMethod::FD)->Apply(ForwardDifferenceArgs);
+
+///////////////////////////////////////////////////////////////////////////////////
+// Project 2 evaluation
+///////////////////////////////////////////////////////////////////////////////////
+
+// Batch evaluation of a Bezier curve, one coordinate at a time. Past
+// cBezierBasisThreshold points this switches to the Bernstein basis.
+static void BM_EvaluateBezier(benchmark::State &aState, bool a3D)
+{
+  auto polygon = RandomPolygon(static_cast<size_t>(aState.range(0)), a3D);
+  std::vector<float> ts;
+  UniformSamples(static_cast<size_t>(aState.range(1)), ts);
+
+  std::vector<float> xs(ts.size());
+  std::vector<float> ys(ts.size());
+  std::vector<float> zs(ts.size());
+  BezierEvaluator evaluator;
+
+  for (auto _ : aState)
+  {
+    evaluator.Evaluate(polygon, ts.data(), ts.size(), xs.data(), ys.data(), zs.data());
+    benchmark::DoNotOptimize(xs.data());
+    benchmark::DoNotOptimize(ys.data());
+    benchmark::DoNotOptimize(zs.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * ts.size());
+}
+BENCHMARK_CAPTURE(BM_EvaluateBezier, 2D, false)->Apply(LinearArgs);
+BENCHMARK_CAPTURE(BM_EvaluateBezier, 3D, true)->Apply(LinearArgs);
+
+// Subdivision down to half a pixel, as Project 2 draws it, with and without
+// collecting the shells of the first split.
+static void BM_SubdivideBezier(benchmark::State &aState, size_t aShellDepth)
+{
+  auto polygon = RandomPolygon(static_cast<size_t>(aState.range(0)), false);
+
+  // Roughly the default camera, looking at the curve across a 720p window.
+  ScreenMapping mapping{ glm::mat4{ 1.0f }, { 1280.0f, 720.0f }, 0.5f };
+  mapping.mModelViewProjection[0][0] = 0.3f;
+  mapping.mModelViewProjection[1][1] = 0.3f;
+
+  BezierSubdivider subdivider;
+  std::vector<glm::vec3> curve;
+  std::vector<glm::vec3> shells;
+
+  for (auto _ : aState)
+  {
+    shells.clear();
+    subdivider.Subdivide(polygon, mapping, curve, &shells, aShellDepth);
+    benchmark::DoNotOptimize(curve.data());
+  }
+
+  aState.counters["vertices"] = static_cast<double>(curve.size());
+}
+BENCHMARK_CAPTURE(BM_SubdivideBezier, NoShells, 0)
+  ->ArgName("points")->Arg(2)->Arg(4)->Arg(10)->Arg(100)->Arg(1000);
+BENCHMARK_CAPTURE(BM_SubdivideBezier, Shells, 1)
+  ->ArgName("points")->Arg(2)->Arg(4)->Arg(10)->Arg(100)->Arg(1000);
+
+///////////////////////////////////////////////////////////////////////////////////
+// Project 3 evaluation
+///////////////////////////////////////////////////////////////////////////////////
+static std::vector<double> RandomValues(size_t aCount)
+{
+  auto points = RandomControlPoints(aCount);
+  return { points.begin(), points.end() };
+}
+
+// What dragging a point used to cost, and still costs when the count changes.
+static void BM_NewtonBuild(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+  auto ys = RandomValues(n);
+  std::vector<double> xs;
+  EquallySpacedNodes(n, xs);
+
+  NewtonInterpolator interpolator;
+
+  for (auto _ : aState)
+  {
+    interpolator.Build(xs, ys);
+    benchmark::DoNotOptimize(interpolator.Coefficients().data());
+  }
+}
+BENCHMARK(BM_NewtonBuild)->ArgName("points")->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+// Dragging one point, including the periodic rebuild.
+static void BM_NewtonSetValue(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+  auto ys = RandomValues(n);
+  std::vector<double> xs;
+  EquallySpacedNodes(n, xs);
+
+  NewtonInterpolator interpolator;
+  interpolator.Build(xs, ys);
+
+  size_t index{ 0 };
+
+  for (auto _ : aState)
+  {
+    index = (index + 7) % n;
+    interpolator.SetValue(index, 0.5 * ys[index]);
+    benchmark::DoNotOptimize(interpolator.Coefficients().data());
+  }
+}
+BENCHMARK(BM_NewtonSetValue)->ArgName("points")->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_NewtonEvaluate(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+  std::vector<double> xs;
+  EquallySpacedNodes(n, xs);
+
+  NewtonInterpolator interpolator;
+  interpolator.Build(xs, RandomValues(n));
+
+  std::vector<float> ts;
+  UniformSamples(static_cast<size_t>(aState.range(1)), ts);
+  std::vector<float> ys(ts.size());
+
+  for (auto _ : aState)
+  {
+    interpolator.Evaluate(ts.data(), ys.data(), ts.size());
+    benchmark::DoNotOptimize(ys.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * ts.size());
+}
+BENCHMARK(BM_NewtonEvaluate)->Apply(LinearArgs);
+
+// Only paid when the nodes change, moving a point doesn't touch the weights.
+static void BM_BarycentricWeights(benchmark::State &aState)
+{
+  std::vector<double> xs;
+  ChebyshevNodes(static_cast<size_t>(aState.range(0)), xs);
+
+  BarycentricInterpolator interpolator;
+
+  for (auto _ : aState)
+  {
+    interpolator.SetNodes(xs);
+    benchmark::DoNotOptimize(interpolator.Weights().data());
+  }
+}
+BENCHMARK(BM_BarycentricWeights)->ArgName("points")->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+static void BM_BarycentricEvaluate(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+  std::vector<double> xs;
+  ChebyshevNodes(n, xs);
+
+  BarycentricInterpolator interpolator;
+  interpolator.SetNodes(xs);
+  interpolator.SetValues(RandomValues(n));
+
+  std::vector<float> ts;
+  UniformSamples(static_cast<size_t>(aState.range(1)), ts);
+  std::vector<float> ys(ts.size());
+
+  for (auto _ : aState)
+  {
+    interpolator.Evaluate(ts.data(), ys.data(), ts.size());
+    benchmark::DoNotOptimize(ys.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * ts.size());
+}
+BENCHMARK(BM_BarycentricEvaluate)->Apply(LinearArgs);
+
+///////////////////////////////////////////////////////////////////////////////////
+// Project 4 evaluation
+///////////////////////////////////////////////////////////////////////////////////
+// Only paid when the knots or end condition change.
+static void BM_SplineFactor(benchmark::State &aState)
+{
+  std::vector<double> xs;
+  EquallySpacedNodes(static_cast<size_t>(aState.range(0)), xs);
+
+  CubicSpline spline;
+
+  for (auto _ : aState)
+  {
+    spline.SetKnots(xs, SplineEnd::Natural);
+    benchmark::DoNotOptimize(spline.Moments().data());
+  }
+}
+BENCHMARK(BM_SplineFactor)->ArgName("knots")->Arg(100)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+// Dragging one point, a solve against the cached factorization.
+static void BM_SplineSolve(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+  auto ys = RandomValues(n);
+  std::vector<double> xs;
+  EquallySpacedNodes(n, xs);
+
+  CubicSpline spline;
+  spline.SetKnots(xs, SplineEnd::Natural);
+  spline.SetValues(ys);
+
+  size_t index{ 0 };
+
+  for (auto _ : aState)
+  {
+    index = (index + 7) % n;
+    spline.SetValue(index, 0.5 * ys[index]);
+    spline.Solve();
+    benchmark::DoNotOptimize(spline.Moments().data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * n);
+}
+BENCHMARK(BM_SplineSolve)->ArgName("knots")->Arg(100)->Arg(10000)->Arg(1000000)->Unit(benchmark::kMillisecond);
+
+static void BM_SplineEvaluate(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+  std::vector<double> xs;
+  EquallySpacedNodes(n, xs);
+
+  CubicSpline spline;
+  spline.SetKnots(xs, SplineEnd::Natural);
+  spline.SetValues(RandomValues(n));
+  spline.Solve();
+
+  std::vector<float> ts;
+  UniformSamples(static_cast<size_t>(aState.range(1)), ts);
+  std::vector<float> ys(ts.size());
+
+  for (auto _ : aState)
+  {
+    spline.Evaluate(ts.data(), ys.data(), ts.size());
+    benchmark::DoNotOptimize(ys.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * ts.size());
+}
+BENCHMARK(BM_SplineEvaluate)->Apply(LinearArgs);
+
+///////////////////////////////////////////////////////////////////////////////////
+// Picking
+///////////////////////////////////////////////////////////////////////////////////
+// The CPU side of PointDrawer::FromYValues, paid whenever a point moves.
+static void BM_LayoutFunctionPoints(benchmark::State &aState)
+{
+  auto n = static_cast<size_t>(aState.range(0));
+  auto ys = RandomControlPoints(n);
+
+  std::vector<float> xs;
+  UniformSamples(aState.range(1) ? n : 0, xs);
+
+  std::vector<glm::vec3> points;
+
+  for (auto _ : aState)
+  {
+    LayoutFunctionPoints(ys, xs, points);
+    benchmark::DoNotOptimize(points.data());
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * n);
+}
+BENCHMARK(BM_LayoutFunctionPoints)->ArgNames({ "points", "xs" })->ArgsProduct({ { 2, 100, 1000, 100000 }, { 0, 1 } });
+
+static void BM_PickControlPoint(benchmark::State &aState)
+{
+  auto points = RandomControlPoints(static_cast<size_t>(aState.range(0)));
+
+  std::mt19937 generator{ 300 };
+  std::uniform_real_distribution<float> x{ 0.0f, 1.0f };
+  std::uniform_real_distribution<float> y{ -3.0f, 3.0f };
+
+  std::vector<glm::vec2> clicks(256);
+
+  for (auto &click : clicks)
+  {
+    click = { x(generator), y(generator) };
+  }
+
+  for (auto _ : aState)
+  {
+    for (auto &click : clicks)
+    {
+      benchmark::DoNotOptimize(PickControlPoint(points, click, 0.06f));
+    }
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * clicks.size());
+}
+BENCHMARK(BM_PickControlPoint)->ArgName("points")->Arg(2)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000)->Arg(100000);
+
+// Free points have no order to search by, so this is a full scan.
+static void BM_PickFreePoint(benchmark::State &aState)
+{
+  auto polygon = RandomPolygon(static_cast<size_t>(aState.range(0)), false);
+
+  std::mt19937 generator{ 300 };
+  std::uniform_real_distribution<float> distribution{ -3.0f, 3.0f };
+
+  std::vector<glm::vec2> clicks(256);
+
+  for (auto &click : clicks)
+  {
+    click = { distribution(generator), distribution(generator) };
+  }
+
+  for (auto _ : aState)
+  {
+    for (auto &click : clicks)
+    {
+      benchmark::DoNotOptimize(PickControlPoint(polygon, click, 0.06f));
+    }
+  }
+
+  aState.SetItemsProcessed(aState.iterations() * clicks.size());
+}
+BENCHMARK(BM_PickFreePoint)->ArgName("points")->Arg(2)->Arg(10)->Arg(100)->Arg(1000)->Arg(10000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,439 @@
+#include <cmath>
+
+#include <algorithm>
+
+#include "CurveEvaluation.hpp"
+
+///////////////////////////////////////////////////////////////////////////////////
+// SamplePolynomial
+///////////////////////////////////////////////////////////////////////////////////
+static void SampleSerial(PolynomialMethod aMethod,
+                         const std::vector<float> &aPoints,
+                         const float *aTs,
+                         float *aYs,
+                         size_t aCount)
+{
+  // Scratch for whichever thread is running this.
+  thread_local std::vector<float> q;
+  thread_local BernsteinBasis bernstein;
+
+  switch (aMethod)
+  {
+    case PolynomialMethod::NLI:
+    case PolynomialMethod::FD:
+    {
+      EvaluateDeCasteljau(aPoints.data(), aPoints.size(), aTs, aYs, aCount, q);
+      break;
+    }
+    case PolynomialMethod::BB:
+    {
+      bernstein.SetDegree(aPoints.size() - 1);
+
+      for (size_t i{ 0 }; i < aCount; ++i)
+      {
+        aYs[i] = bernstein.Evaluate(aPoints.data(), aTs[i]);
+      }
+      break;
+    }
+  }
+}
+
+void SamplePolynomial(PolynomialMethod aMethod,
+                      const std::vector<float> &aPoints,
+                      const float *aTs,
+                      float *aYs,
+                      size_t aCount,
+                      ThreadPool *aPool,
+                      size_t aThreads)
+{
+  if (nullptr == aPool || aCount <= cParallelSampleGrain)
+  {
+    SampleSerial(aMethod, aPoints, aTs, aYs, aCount);
+    return;
+  }
+
+  aPool->ParallelFor(aCount, cParallelSampleGrain, [&](size_t aBegin, size_t aEnd)
+  {
+    SampleSerial(aMethod, aPoints, aTs + aBegin, aYs + aBegin, aEnd - aBegin);
+  }, aThreads);
+}
+
+void SampleUniformPolynomial(const std::vector<float> &aPoints,
+                             float *aYs,
+                             size_t aCount,
+                             ThreadPool *aPool,
+                             size_t aThreads)
+{
+  thread_local std::vector<double> scratch;
+  thread_local std::vector<float> ts;
+
+  if (aPoints.size() > cForwardDifferenceMaxDegree + 1)
+  {
+    UniformSamples(aCount, ts);
+    SamplePolynomial(PolynomialMethod::NLI, aPoints, ts.data(), aYs, aCount, aPool, aThreads);
+    return;
+  }
+
+  if (nullptr == aPool || aCount <= cParallelSampleGrain)
+  {
+    EvaluateForwardDifferences(aPoints.data(), aPoints.size(), 0, aCount, aCount, aYs, 0, scratch);
+    return;
+  }
+
+  // Each range anchors itself, so they can be split anywhere.
+  aPool->ParallelFor(aCount, cParallelSampleGrain, [&](size_t aBegin, size_t aEnd)
+  {
+    EvaluateForwardDifferences(aPoints.data(), aPoints.size(), aBegin, aEnd - aBegin, aCount, aYs + aBegin, 0, scratch);
+  }, aThreads);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// PolynomialCurveEvaluator
+///////////////////////////////////////////////////////////////////////////////////
+PolynomialCurveEvaluator::PolynomialCurveEvaluator(ThreadPool *aPool)
+  : mPool(aPool)
+{
+}
+
+bool PolynomialCurveEvaluator::Evaluate(const PolynomialCurveInput &aInput,
+                                        std::vector<glm::vec2> &aOut,
+                                        const CancelCheck &aCancelled)
+{
+  auto &points = *aInput.mPoints;
+
+  if (PolynomialMethod::FD == aInput.mMethod)
+  {
+    auto count = std::max<size_t>(aInput.mSamples, 2);
+    auto step = 1.0f / (count - 1);
+
+    mYs.resize(count);
+    SampleUniformPolynomial(points, mYs.data(), count, mPool);
+
+    aOut.resize(count);
+
+    for (size_t i{ 0 }; i < count; ++i)
+    {
+      aOut[i] = { i * step, mYs[i] };
+    }
+
+    return true;
+  }
+
+  return mTessellator.Tessellate([&](const float *aTs, float *aYs, size_t aCount)
+  {
+    SamplePolynomial(aInput.mMethod, points, aTs, aYs, aCount, mPool);
+  }, aInput.mMapping, aOut, aCancelled);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// AsyncPolynomialEvaluator
+///////////////////////////////////////////////////////////////////////////////////
+AsyncPolynomialEvaluator::AsyncPolynomialEvaluator(ThreadPool &aPool)
+  : mPool(aPool)
+  , mRunning(false)
+  , mMustFinish(false)
+  , mGeneration(0)
+  , mBusy(false)
+{
+}
+
+AsyncPolynomialEvaluator::~AsyncPolynomialEvaluator()
+{
+  std::unique_lock<std::mutex> lock(mMutex);
+
+  mPending.reset();
+  mMustFinish = false;
+  ++mGeneration;
+
+  mIdle.wait(lock, [this]() { return false == mRunning; });
+}
+
+void AsyncPolynomialEvaluator::Submit(PolynomialCurveInput aInput)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  mPending = std::move(aInput);
+  ++mGeneration;
+  mBusy = true;
+
+  if (false == mRunning)
+  {
+    mRunning = true;
+    mPool.Enqueue([this]() { Run(); });
+  }
+}
+
+bool AsyncPolynomialEvaluator::Update()
+{
+  return mResults.Update();
+}
+
+const EvaluatedPolynomialCurve& AsyncPolynomialEvaluator::Latest() const
+{
+  return mResults.Front();
+}
+
+bool AsyncPolynomialEvaluator::Busy() const
+{
+  return mBusy;
+}
+
+// Keeps evaluating whatever was submitted last until nothing is waiting.
+void AsyncPolynomialEvaluator::Run()
+{
+  while (true)
+  {
+    PolynomialCurveInput input;
+    size_t generation;
+    bool mustFinish;
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+
+      if (false == mPending.has_value())
+      {
+        mRunning = false;
+        mBusy = false;
+        mIdle.notify_all();
+        return;
+      }
+
+      input = std::move(*mPending);
+      mPending.reset();
+      generation = mGeneration;
+      mustFinish = mMustFinish;
+    }
+
+    auto &result = mResults.Back();
+
+    auto finished = mEvaluator.Evaluate(input, result.mPoints, [&]()
+    {
+      return false == mustFinish && generation != mGeneration.load(std::memory_order_relaxed);
+    });
+
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mMustFinish = false == finished;
+    }
+
+    if (finished)
+    {
+      result.mInput = std::move(input);
+      mResults.Publish();
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Bezier curves
+///////////////////////////////////////////////////////////////////////////////////
+// Evaluates samples [aBegin, aEnd) of aCount into aOut.
+static void SampleBezierRange(const BezierControlPolygon &aPolygon,
+                              size_t aBegin,
+                              size_t aEnd,
+                              size_t aCount,
+                              glm::vec3 *aOut)
+{
+  // Scratch for whichever thread is running this.
+  thread_local std::vector<float> ts;
+  thread_local std::vector<float> xs;
+  thread_local std::vector<float> ys;
+  thread_local std::vector<float> zs;
+  thread_local BezierEvaluator evaluator;
+
+  auto count = aEnd - aBegin;
+  auto offset = (aCount > 1) ? 1.0f / (aCount - 1) : 0.0f;
+
+  ts.resize(count);
+  xs.resize(count);
+  ys.resize(count);
+  zs.assign(count, 0.0f);
+
+  for (size_t i{ 0 }; i < count; ++i)
+  {
+    ts[i] = (aBegin + i) * offset;
+  }
+
+  evaluator.Evaluate(aPolygon, ts.data(), count, xs.data(), ys.data(), zs.data());
+
+  for (size_t i{ 0 }; i < count; ++i)
+  {
+    aOut[i] = { xs[i], ys[i], zs[i] };
+  }
+}
+
+void SampleBezier(const BezierControlPolygon &aPolygon,
+                  size_t aCount,
+                  std::vector<glm::vec3> &aOut,
+                  ThreadPool *aPool,
+                  size_t aThreads)
+{
+  aOut.resize(aCount);
+
+  if (nullptr == aPool || aCount <= cParallelSampleGrain)
+  {
+    SampleBezierRange(aPolygon, 0, aCount, aCount, aOut.data());
+    return;
+  }
+
+  aPool->ParallelFor(aCount, cParallelSampleGrain, [&](size_t aBegin, size_t aEnd)
+  {
+    SampleBezierRange(aPolygon, aBegin, aEnd, aCount, aOut.data() + aBegin);
+  }, aThreads);
+}
+
+BezierCurveEvaluator::BezierCurveEvaluator(ThreadPool *aPool)
+  : mPool(aPool)
+{
+}
+
+void BezierCurveEvaluator::Evaluate(const BezierCurveInput &aInput,
+                                    std::vector<glm::vec3> &aOut,
+                                    std::vector<glm::vec3> &aShells)
+{
+  aShells.clear();
+
+  switch (aInput.mMethod)
+  {
+    case BezierMethod::Sampled:
+    {
+      SampleBezier(*aInput.mPolygon, std::max<size_t>(aInput.mSamples, 2), aOut, mPool);
+      break;
+    }
+    case BezierMethod::Subdivided:
+    {
+      mSubdivider.Subdivide(*aInput.mPolygon, aInput.mMapping, aOut, &aShells, aInput.mShellDepth);
+      break;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Interpolating polynomials
+///////////////////////////////////////////////////////////////////////////////////
+void EquallySpacedNodes(size_t aCount, std::vector<double> &aXs)
+{
+  aXs.resize(aCount);
+
+  for (size_t i{ 0 }; i < aCount; ++i)
+  {
+    aXs[i] = (aCount > 1) ? static_cast<double>(i) / (aCount - 1) : 0.0;
+  }
+}
+
+void ChebyshevNodes(size_t aCount, std::vector<double> &aXs)
+{
+  constexpr double cPi = 3.14159265358979323846;
+
+  aXs.resize(aCount);
+
+  for (size_t i{ 0 }; i < aCount; ++i)
+  {
+    aXs[i] = (aCount > 1) ? 0.5 - 0.5 * std::cos(cPi * i / (aCount - 1)) : 0.0;
+  }
+}
+
+bool SyncInterpolator(NewtonInterpolator &aInterpolator,
+                      const std::vector<double> &aXs,
+                      const std::vector<float> &aYs)
+{
+  auto n = aYs.size();
+
+  auto rebuild = [&]()
+  {
+    aInterpolator.Build(aXs, std::vector<double>(aYs.begin(), aYs.end()));
+    return true;
+  };
+
+  if (aInterpolator.Xs() != aXs)
+  {
+    return rebuild();
+  }
+
+  auto &ys = aInterpolator.Ys();
+  size_t changed{ 0 };
+
+  for (size_t i{ 0 }; i < n; ++i)
+  {
+    changed += (ys[i] != aYs[i]) ? 1 : 0;
+  }
+
+  if (0 == changed)
+  {
+    return false;
+  }
+
+  // Each move costs about 3n divisions to the rebuild's n^2 / 2, and a single
+  // move (someone dragging a point) always goes through SetValue.
+  if (changed > std::max<size_t>(1, n / 8))
+  {
+    return rebuild();
+  }
+
+  for (size_t i{ 0 }; i < n; ++i)
+  {
+    if (ys[i] != aYs[i])
+    {
+      aInterpolator.SetValue(i, aYs[i]);
+    }
+  }
+
+  return true;
+}
+
+bool SyncInterpolator(BarycentricInterpolator &aInterpolator,
+                      const std::vector<double> &aXs,
+                      const std::vector<float> &aYs)
+{
+  bool changed{ false };
+
+  if (aInterpolator.Xs() != aXs)
+  {
+    aInterpolator.SetNodes(aXs);
+    changed = true;
+  }
+
+  auto &ys = aInterpolator.Ys();
+
+  for (size_t i{ 0 }; i < aYs.size(); ++i)
+  {
+    if (ys[i] != aYs[i])
+    {
+      aInterpolator.SetValue(i, aYs[i]);
+      changed = true;
+    }
+  }
+
+  return changed;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Cubic splines
+///////////////////////////////////////////////////////////////////////////////////
+bool SyncSpline(CubicSpline &aSpline,
+                const std::vector<double> &aXs,
+                SplineEnd aEnd,
+                const std::vector<float> &aYs)
+{
+  bool changed{ false };
+
+  if (aSpline.End() != aEnd || aSpline.Xs() != aXs)
+  {
+    aSpline.SetKnots(aXs, aEnd);
+    changed = true;
+  }
+
+  auto &ys = aSpline.Ys();
+
+  for (size_t i{ 0 }; i < aYs.size(); ++i)
+  {
+    if (ys[i] != aYs[i])
+    {
+      aSpline.SetValue(i, aYs[i]);
+      changed = true;
+    }
+  }
+
+  aSpline.Solve();
+  return changed;
+}
@@ -0,0 +1,279 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "CurveMath.hpp"
+#include "ThreadPool.hpp"
+#include "TripleBuffer.hpp"
+
+// The evaluation layer: given everything a curve depends on, produce its
+// vertices. Nothing in here knows about ImGui, GL or Project, so it can run
+// on any thread. The project functions are split into stages around it:
+// UI (edit the settings), snapshot (capture the inputs), evaluate, and
+// submit (hand the vertices to the drawers).
+
+// Immutable copy of the control points. Shared rather than copied again for
+// every evaluation that uses the same points.
+using ControlPointSnapshot = std::shared_ptr<const std::vector<float>>;
+
+inline ControlPointSnapshot MakeSnapshot(const std::vector<float> &aPoints)
+{
+  return std::make_shared<const std::vector<float>>(aPoints);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Polynomial functions (Project 1)
+///////////////////////////////////////////////////////////////////////////////////
+enum class PolynomialMethod : int
+{
+  NLI = 0,
+  BB = 1,
+
+  // Forward differences over a fixed number of evenly spaced samples,
+  // rather than tessellating adaptively.
+  FD = 2
+};
+
+// Batches at least this large are split across threads by SamplePolynomial.
+constexpr size_t cParallelSampleGrain = 2048;
+
+// Evaluates the polynomial with Bernstein coefficients aPoints at each of
+// aTs, writing to aYs. Given a pool, batches of more than one grain are
+// split across it with ThreadPool::ParallelFor, each thread writing its own
+// stretch of aYs. aThreads limits how many threads take part, 0 for all.
+//
+// Forward differencing needs evenly spaced samples, so FD falls back to
+// de Casteljau here, see SampleUniformPolynomial.
+void SamplePolynomial(PolynomialMethod aMethod,
+                      const std::vector<float> &aPoints,
+                      const float *aTs,
+                      float *aYs,
+                      size_t aCount,
+                      ThreadPool *aPool = nullptr,
+                      size_t aThreads = 0);
+
+// Forward differences the aCount evenly spaced samples UniformSamples would
+// give into aYs, split across aPool like SamplePolynomial. Degrees past
+// cForwardDifferenceMaxDegree take the same samples with de Casteljau
+// instead.
+void SampleUniformPolynomial(const std::vector<float> &aPoints,
+                             float *aYs,
+                             size_t aCount,
+                             ThreadPool *aPool = nullptr,
+                             size_t aThreads = 0);
+
+// Everything a Project 1 curve depends on.
+struct PolynomialCurveInput
+{
+  // Bernstein coefficients, at least one.
+  ControlPointSnapshot mPoints;
+  PolynomialMethod mMethod;
+  ScreenMapping mMapping;
+
+  // How many evenly spaced samples FD takes, at least two.
+  size_t mSamples;
+
+  // Project::mRevision the points were taken at, so the result can be
+  // matched back up with the state it came from.
+  size_t mRevision;
+};
+
+// Produces the (t, f(t)) graph of a polynomial function, tessellated to the
+// input's screen mapping, or sampled evenly for FD. The output depends only
+// on the input, the members are just scratch space reused between calls, so
+// each thread wants its own evaluator.
+class PolynomialCurveEvaluator
+{
+public:
+  // Large batches of samples are spread over aPool, if given.
+  explicit PolynomialCurveEvaluator(ThreadPool *aPool = &ThreadPool::Shared());
+
+  // Returns false if aCancelled stopped it part way.
+  bool Evaluate(const PolynomialCurveInput &aInput,
+                std::vector<glm::vec2> &aOut,
+                const CancelCheck &aCancelled = nullptr);
+
+private:
+  AdaptiveTessellator mTessellator;
+  std::vector<float> mYs;
+  ThreadPool *mPool;
+};
+
+struct EvaluatedPolynomialCurve
+{
+  PolynomialCurveInput mInput;
+  std::vector<glm::vec2> mPoints;
+};
+
+// Evaluates Project 1 curves on a thread pool so a slow evaluation never
+// holds up a frame. The render thread Submit()s inputs and, each frame,
+// Update()s to pick up the newest finished curve, which it can keep drawing
+// for as long as it likes.
+//
+// At most one evaluation runs at a time. Submitting while one is running
+// replaces whatever was waiting and cancels the running one, since its
+// result is already out of date. So that dragging a point every frame can't
+// cancel everything forever, a job that follows a cancelled one is always
+// allowed to finish.
+class AsyncPolynomialEvaluator
+{
+public:
+  explicit AsyncPolynomialEvaluator(ThreadPool &aPool = ThreadPool::Shared());
+
+  // Cancels any running evaluation and waits for it to stop.
+  ~AsyncPolynomialEvaluator();
+
+  AsyncPolynomialEvaluator(const AsyncPolynomialEvaluator&) = delete;
+  AsyncPolynomialEvaluator& operator=(const AsyncPolynomialEvaluator&) = delete;
+
+  void Submit(PolynomialCurveInput aInput);
+
+  // Render thread only. Returns true if Latest() changed.
+  bool Update();
+
+  // Most recent finished curve, empty until the first one finishes.
+  const EvaluatedPolynomialCurve& Latest() const;
+
+  // True while anything submitted hasn't finished yet.
+  bool Busy() const;
+
+private:
+  void Run();
+
+  ThreadPool &mPool;
+
+  std::mutex mMutex;
+  std::condition_variable mIdle;
+  std::optional<PolynomialCurveInput> mPending;
+  bool mRunning;
+  bool mMustFinish;
+
+  // Bumped by every Submit, the running job is stale once it moves on.
+  std::atomic<size_t> mGeneration;
+  std::atomic<bool> mBusy;
+
+  // Only touched by the running job.
+  PolynomialCurveEvaluator mEvaluator;
+
+  TripleBuffer<EvaluatedPolynomialCurve> mResults;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Bezier curves (Project 2)
+///////////////////////////////////////////////////////////////////////////////////
+using BezierPolygonSnapshot = std::shared_ptr<const BezierControlPolygon>;
+
+inline BezierPolygonSnapshot MakeSnapshot(const BezierControlPolygon &aPolygon)
+{
+  return std::make_shared<const BezierControlPolygon>(aPolygon);
+}
+
+// Evaluates the curve at aCount evenly spaced ts covering [0, 1], writing
+// to aOut. Batches of more than one grain are split across aPool like
+// SamplePolynomial, each thread evaluating its stretch a coordinate at a time
+// before interleaving it into aOut.
+void SampleBezier(const BezierControlPolygon &aPolygon,
+                  size_t aCount,
+                  std::vector<glm::vec3> &aOut,
+                  ThreadPool *aPool = nullptr,
+                  size_t aThreads = 0);
+
+enum class BezierMethod : int
+{
+  // Evenly spaced samples, see SampleBezier.
+  Sampled = 0,
+
+  // Split in half until flat on screen, see BezierSubdivider.
+  Subdivided = 1
+};
+
+// Everything a Project 2 curve depends on.
+struct BezierCurveInput
+{
+  // At least one point.
+  BezierPolygonSnapshot mPolygon;
+  BezierMethod mMethod;
+
+  // How many evenly spaced samples Sampled takes, at least two.
+  size_t mSamples;
+
+  // Where Subdivided flattens the curve to.
+  ScreenMapping mMapping;
+
+  // Subdivided hands out the shells of splits shallower than this, 0 for
+  // none.
+  size_t mShellDepth;
+
+  // Project::mRevision the points were taken at.
+  size_t mRevision;
+};
+
+// Produces the vertices of a Bezier curve. Like PolynomialCurveEvaluator
+// the output depends only on the input.
+class BezierCurveEvaluator
+{
+public:
+  explicit BezierCurveEvaluator(ThreadPool *aPool = &ThreadPool::Shared());
+
+  // aShells gets pairs of line end points, see BezierSubdivider.
+  void Evaluate(const BezierCurveInput &aInput,
+                std::vector<glm::vec3> &aOut,
+                std::vector<glm::vec3> &aShells);
+
+private:
+  BezierSubdivider mSubdivider;
+  ThreadPool *mPool;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Interpolating polynomials (Project 3)
+///////////////////////////////////////////////////////////////////////////////////
+
+enum class InterpolationMethod : int
+{
+  Newton = 0,
+  Barycentric = 1
+};
+
+// Nodes at the xs PointDrawer::FromYValues draws the control points at.
+void EquallySpacedNodes(size_t aCount, std::vector<double> &aXs);
+
+// Chebyshev points of the second kind mapped to [0, 1], ends included.
+// Bunched up towards the ends, which keeps interpolating hundreds of them
+// well behaved where evenly spaced nodes blow up at the ends.
+void ChebyshevNodes(size_t aCount, std::vector<double> &aXs);
+
+// Brings aInterpolator up to date with the control points aYs, interpolated
+// at aXs. Only the points that changed since the last call are moved, O(n)
+// each, unless so many changed that rebuilding is cheaper. Different nodes
+// always rebuild. Returns true if anything changed.
+bool SyncInterpolator(NewtonInterpolator &aInterpolator,
+                      const std::vector<double> &aXs,
+                      const std::vector<float> &aYs);
+
+// Same for the barycentric form, where only new nodes cost O(n^2), changed
+// values are just copied in.
+bool SyncInterpolator(BarycentricInterpolator &aInterpolator,
+                      const std::vector<double> &aXs,
+                      const std::vector<float> &aYs);
+
+///////////////////////////////////////////////////////////////////////////////////
+// Cubic splines (Project 4)
+///////////////////////////////////////////////////////////////////////////////////
+
+// Brings aSpline up to date with the control points aYs at knots aXs. The
+// system is only factored again when the knots or end condition change,
+// otherwise changed values just solve it again. Returns true if anything
+// changed.
+bool SyncSpline(CubicSpline &aSpline,
+                const std::vector<double> &aXs,
+                SplineEnd aEnd,
+                const std::vector<float> &aYs);
@@ -0,0 +1,1442 @@
+#include <cmath>
+
+#include <algorithm>
+#include <limits>
+
+#include "CurveMath.hpp"
+
+size_t factorial(size_t n)
+{
+  if (0 == n)
+  {
+    return 1;
+  }
+
+  size_t product{ n };
+
+  for (size_t i{ n - 1 }; i > 0; --i)
+  {
+    product *= i;
+  }
+
+  return product;
+}
+
+// log(C(n, k + 1) / C(n, k)). Binomials are built up from these rather than
+// with lgamma, which isn't thread safe (it sets the global signgam).
+static double LogBinomialStep(size_t aN, size_t aK)
+{
+  return std::log(static_cast<double>(aN - aK)) - std::log(static_cast<double>(aK + 1));
+}
+
+// glibc's lgamma_r leaves signgam alone, elsewhere this falls back to the
+// steps, O(min(k, n - k)).
+static double LogBinomial(size_t aN, size_t aK)
+{
+#if defined(__GLIBC__)
+  int sign;
+  return lgamma_r(aN + 1.0, &sign) - lgamma_r(aK + 1.0, &sign) - lgamma_r(aN - aK + 1.0, &sign);
+#else
+  aK = std::min(aK, aN - aK);
+
+  double logBinomial{ 0.0 };
+
+  for (size_t i{ 0 }; i < aK; ++i)
+  {
+    logBinomial += LogBinomialStep(aN, i);
+  }
+
+  return logBinomial;
+#endif
+}
+
+float BernstienPolynomial(size_t d, size_t i, float t)
+{
+  if (t <= 0.0f)
+  {
+    return (0 == i) ? 1.0f : 0.0f;
+  }
+
+  if (t >= 1.0f)
+  {
+    return (d == i) ? 1.0f : 0.0f;
+  }
+
+  //((1-t)^(d-i)) * (t^i) * ((d!)/((d - i)! * i!))
+  return static_cast<float>(std::exp(LogBinomial(d, i) +
+                                     i * std::log(t) +
+                                     (d - i) * std::log1p(-t)));
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// BernsteinBasis
+///////////////////////////////////////////////////////////////////////////////////
+BernsteinBasis::BernsteinBasis()
+  : mDegree(0)
+{
+  mLogBinomials.resize(1, 0.0);
+  mBasis.resize(1, 1.0);
+}
+
+void BernsteinBasis::SetDegree(size_t aDegree)
+{
+  if (aDegree == mDegree)
+  {
+    return;
+  }
+
+  mDegree = aDegree;
+  mLogBinomials.resize(aDegree + 1);
+  mUpFactors.resize(aDegree + 1);
+  mDownFactors.resize(aDegree + 1);
+  mBasis.resize(aDegree + 1);
+
+  for (size_t i{ 0 }; i <= aDegree; ++i)
+  {
+    mUpFactors[i] = static_cast<double>(aDegree - i) / (i + 1);
+    mDownFactors[i] = static_cast<double>(i) / (aDegree - i + 1);
+  }
+
+  // Built up with C(d, i + 1) = C(d, i) * (d - i) / (i + 1).
+  mLogBinomials[0] = 0.0;
+
+  for (size_t i{ 0 }; i < aDegree; ++i)
+  {
+    mLogBinomials[i + 1] = mLogBinomials[i] + LogBinomialStep(aDegree, i);
+  }
+}
+
+std::pair<size_t, size_t> BernsteinBasis::Evaluate(double aT, double *aBasis) const
+{
+  // The basis sums to one, so anything this small can't show up in a float.
+  constexpr double cNegligible = 1e-30;
+
+  auto d = mDegree;
+
+  std::fill(aBasis, aBasis + d + 1, 0.0);
+
+  if (aT <= 0.0 || aT >= 1.0)
+  {
+    auto i = (aT <= 0.0) ? 0 : d;
+    aBasis[i] = 1.0;
+    return { i, i };
+  }
+
+  // Start at the mode of the distribution, it's the one value we know can't
+  // underflow, then walk the ratio outwards in both directions. Values only
+  // shrink away from the mode, so each walk stops once they're negligible.
+  auto mode = std::min(static_cast<size_t>(aT * (d + 1)), d);
+
+  aBasis[mode] = std::exp(mLogBinomials[mode] +
+                          mode * std::log(aT) +
+                          (d - mode) * std::log1p(-aT));
+
+  double ratio = aT / (1.0 - aT);
+  double inverseRatio = (1.0 - aT) / aT;
+
+  auto last = mode;
+
+  while (last < d && aBasis[last] > cNegligible)
+  {
+    aBasis[last + 1] = aBasis[last] * ratio * mUpFactors[last];
+    ++last;
+  }
+
+  auto first = mode;
+
+  while (first > 0 && aBasis[first] > cNegligible)
+  {
+    aBasis[first - 1] = aBasis[first] * inverseRatio * mDownFactors[first];
+    --first;
+  }
+
+  return { first, last };
+}
+
+float BernsteinBasis::Evaluate(const float *aCoefficients, float aT)
+{
+  auto [first, last] = Evaluate(aT, mBasis.data());
+
+  double sum{ 0.0 };
+
+  for (size_t i{ first }; i <= last; ++i)
+  {
+    sum += mBasis[i] * aCoefficients[i];
+  }
+
+  return static_cast<float>(sum);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// De Casteljau
+///////////////////////////////////////////////////////////////////////////////////
+void UniformSamples(size_t aCount, std::vector<float> &aTs)
+{
+  aTs.resize(aCount);
+
+  if (1 == aCount)
+  {
+    aTs[0] = 0.0f;
+    return;
+  }
+
+  auto offset = 1.0f / (aCount - 1);
+
+  // Same values, but x86 converts signed integers to float in one
+  // instruction and unsigned ones in a dozen.
+  for (std::ptrdiff_t i{ 0 }; i < static_cast<std::ptrdiff_t>(aCount); ++i)
+  {
+    aTs[i] = i * offset;
+  }
+}
+
+void EvaluateDeCasteljau(const float *aCoefficients,
+                         size_t aCoefficientCount,
+                         const float *aTs,
+                         float *aOut,
+                         size_t aSampleCount,
+                         std::vector<float> &aScratch)
+{
+  static const SimdLevel level = DetectSimdLevel();
+
+  EvaluateDeCasteljau(aCoefficients, aCoefficientCount, aTs, aOut, aSampleCount, aScratch, level);
+}
+
+void EvaluateDeCasteljau(const float *aCoefficients,
+                         size_t aCoefficientCount,
+                         const float *aTs,
+                         float *aOut,
+                         size_t aSampleCount,
+                         std::vector<float> &aScratch,
+                         SimdLevel aLevel)
+{
+  if (0 == aCoefficientCount)
+  {
+    std::fill(aOut, aOut + aSampleCount, 0.0f);
+    return;
+  }
+
+  auto kernel = GetDeCasteljauKernel(aLevel);
+
+  // Row i of a block holds Q[i] for every sample in the block, followed by
+  // one row of u and one of (1 - u).
+  aScratch.resize((aCoefficientCount + 2) * cDeCasteljauBlock);
+  float *u = aScratch.data() + aCoefficientCount * cDeCasteljauBlock;
+  float *oneMinusU = u + cDeCasteljauBlock;
+
+  for (size_t start{ 0 }; start < aSampleCount; start += cDeCasteljauBlock)
+  {
+    auto count = std::min(cDeCasteljauBlock, aSampleCount - start);
+
+    // The kernels always run a full block, so pad out the last one.
+    for (size_t s{ 0 }; s < cDeCasteljauBlock; ++s)
+    {
+      u[s] = (s < count) ? aTs[start + s] : 0.0f;
+      oneMinusU[s] = 1.0f - u[s];
+    }
+
+    for (size_t i{ 0 }; i < aCoefficientCount; ++i)
+    {
+      std::fill_n(aScratch.data() + i * cDeCasteljauBlock, cDeCasteljauBlock, aCoefficients[i]);
+    }
+
+    // Referenced: 
+    // https://pages.mtu.edu/~shene/COURSES/cs3621/NOTES/spline/Bezier/de-casteljau.html
+    kernel(aScratch.data(), u, oneMinusU, aCoefficientCount - 1);
+
+    std::copy_n(aScratch.data(), count, aOut + start);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Forward Differencing
+///////////////////////////////////////////////////////////////////////////////////
+// Single de Casteljau evaluation in double, aRow needs aCount entries.
+static double DeCasteljauDouble(const float *aCoefficients, size_t aCount, double aT, double *aRow)
+{
+  std::copy_n(aCoefficients, aCount, aRow);
+
+  for (size_t k{ 1 }; k < aCount; ++k)
+  {
+    for (size_t i{ 0 }; i < aCount - k; ++i)
+    {
+      aRow[i] = (1.0 - aT) * aRow[i] + aT * aRow[i + 1];
+    }
+  }
+
+  return aRow[0];
+}
+
+static size_t ComputeAnchorInterval(size_t aDegree)
+{
+  // Rounding error in the d-th difference reaches sample n multiplied by
+  // C(n, d), and the differences themselves start off around 2^d times
+  // larger than the curve. Keep that product well below float precision.
+  constexpr double cGrowthLimit = 1e8;
+  constexpr size_t cMaxInterval = 4096;
+
+  double growth = std::ldexp(1.0, static_cast<int>(std::min<size_t>(aDegree, 1000)));
+  size_t interval{ aDegree + 1 };
+
+  while (interval < cMaxInterval)
+  {
+    // C(interval, d) from C(interval - 1, d).
+    auto next = growth * interval / (interval - aDegree);
+
+    if (next > cGrowthLimit)
+    {
+      break;
+    }
+
+    growth = next;
+    ++interval;
+  }
+
+  return interval;
+}
+
+size_t ForwardDifferenceAnchorInterval(size_t aDegree)
+{
+  // Low degrees walk the longest before giving up, and are the ones forward
+  // differencing gets used for, so don't redo that every call.
+  constexpr size_t cCachedDegrees = 16;
+
+  static const auto cached = []()
+  {
+    std::vector<size_t> intervals(cCachedDegrees);
+
+    for (size_t degree{ 0 }; degree < cCachedDegrees; ++degree)
+    {
+      intervals[degree] = ComputeAnchorInterval(degree);
+    }
+
+    return intervals;
+  }();
+
+  return (aDegree < cCachedDegrees) ? cached[aDegree] : ComputeAnchorInterval(aDegree);
+}
+
+// Steps the difference table aSkip times, then aCount more writing each
+// sample to aOut.
+static void StepDifferences(double *aDifferences, size_t aDegree, size_t aSkip, float *aOut, size_t aCount)
+{
+  for (size_t i{ 0 }; i < aSkip + aCount; ++i)
+  {
+    for (size_t k{ 0 }; k < aDegree; ++k)
+    {
+      aDifferences[k] += aDifferences[k + 1];
+    }
+
+    if (i >= aSkip)
+    {
+      aOut[i - aSkip] = static_cast<float>(aDifferences[0]);
+    }
+  }
+}
+
+// Same for a fixed degree, so the table lives in registers rather than
+// making a round trip through memory every step.
+template <size_t tDegree>
+static void StepDifferences(double *aDifferences, size_t aSkip, float *aOut, size_t aCount)
+{
+  double differences[tDegree + 1];
+  std::copy_n(aDifferences, tDegree + 1, differences);
+
+  auto step = [&differences]()
+  {
+    for (size_t k{ 0 }; k < tDegree; ++k)
+    {
+      differences[k] += differences[k + 1];
+    }
+  };
+
+  for (size_t i{ 0 }; i < aSkip; ++i)
+  {
+    step();
+  }
+
+  for (size_t i{ 0 }; i < aCount; ++i)
+  {
+    step();
+    aOut[i] = static_cast<float>(differences[0]);
+  }
+}
+
+void EvaluateForwardDifferences(const float *aCoefficients,
+                                size_t aCoefficientCount,
+                                size_t aFirst,
+                                size_t aCount,
+                                size_t aSampleCount,
+                                float *aOut,
+                                size_t aAnchorInterval,
+                                std::vector<double> &aScratch)
+{
+  if (0 == aCount)
+  {
+    return;
+  }
+
+  if (0 == aCoefficientCount)
+  {
+    std::fill(aOut, aOut + aCount, 0.0f);
+    return;
+  }
+
+  auto degree = aCoefficientCount - 1;
+  auto anchorInterval = (0 == aAnchorInterval) ? ForwardDifferenceAnchorInterval(degree)
+                                               : std::max(aAnchorInterval, degree + 1);
+  // The differences assume exactly even spacing, so the anchors can't use
+  // the rounded float ts UniformSamples gives.
+  auto offset = (aSampleCount > 1) ? 1.0 / (aSampleCount - 1) : 0.0;
+
+  // The difference table, then a row for de Casteljau.
+  aScratch.resize(2 * aCoefficientCount);
+  double *differences = aScratch.data();
+  double *row = differences + aCoefficientCount;
+
+  for (size_t start{ 0 }; start < aCount; start += anchorInterval)
+  {
+    auto segment = std::min(anchorInterval, aCount - start);
+    auto exact = std::min(degree + 1, segment);
+
+    // Anchor on the first d + 1 samples of the segment, evaluated exactly
+    // in double. Differencing float samples would amplify their rounding
+    // error by up to 2^d straight away.
+    for (size_t i{ 0 }; i < exact; ++i)
+    {
+      double t = (aFirst + start + i) * offset;
+      differences[i] = DeCasteljauDouble(aCoefficients, aCoefficientCount, t, row);
+      aOut[start + i] = static_cast<float>(differences[i]);
+    }
+
+    if (exact == segment)
+    {
+      continue;
+    }
+
+    // Turn the samples into the difference table at the first one,
+    // differences[k] = delta^k f(t).
+    for (size_t k{ 1 }; k <= degree; ++k)
+    {
+      for (size_t i{ degree }; i >= k; --i)
+      {
+        differences[i] -= differences[i - 1];
+      }
+    }
+
+    // Walk the table past the exact samples and on through the segment.
+    auto out = aOut + start + exact;
+    auto count = segment - exact;
+
+    switch (degree)
+    {
+      case 1: StepDifferences<1>(differences, exact - 1, out, count); break;
+      case 2: StepDifferences<2>(differences, exact - 1, out, count); break;
+      case 3: StepDifferences<3>(differences, exact - 1, out, count); break;
+      case 4: StepDifferences<4>(differences, exact - 1, out, count); break;
+      default: StepDifferences(differences, degree, exact - 1, out, count); break;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Bezier Curves
+///////////////////////////////////////////////////////////////////////////////////
+static float Dot(const double *aBasis, const std::vector<float> &aCoordinates, std::pair<size_t, size_t> aRange)
+{
+  double sum{ 0.0 };
+
+  for (size_t i{ aRange.first }; i <= aRange.second; ++i)
+  {
+    sum += aBasis[i] * aCoordinates[i];
+  }
+
+  return static_cast<float>(sum);
+}
+
+void BezierEvaluator::Evaluate(const BezierControlPolygon &aPolygon,
+                               const float *aTs,
+                               size_t aCount,
+                               float *aOutX,
+                               float *aOutY,
+                               float *aOutZ)
+{
+  auto size = aPolygon.Size();
+
+  if (size <= cBezierBasisThreshold)
+  {
+    EvaluateDeCasteljau(aPolygon.mX.data(), size, aTs, aOutX, aCount, mScratch);
+    EvaluateDeCasteljau(aPolygon.mY.data(), size, aTs, aOutY, aCount, mScratch);
+
+    if (aPolygon.Is3D())
+    {
+      EvaluateDeCasteljau(aPolygon.mZ.data(), size, aTs, aOutZ, aCount, mScratch);
+    }
+
+    return;
+  }
+
+  mBasis.SetDegree(size - 1);
+  mBasisValues.resize(size);
+
+  for (size_t i{ 0 }; i < aCount; ++i)
+  {
+    auto range = mBasis.Evaluate(aTs[i], mBasisValues.data());
+
+    aOutX[i] = Dot(mBasisValues.data(), aPolygon.mX, range);
+    aOutY[i] = Dot(mBasisValues.data(), aPolygon.mY, range);
+
+    if (aPolygon.Is3D())
+    {
+      aOutZ[i] = Dot(mBasisValues.data(), aPolygon.mZ, range);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// NewtonInterpolator
+///////////////////////////////////////////////////////////////////////////////////
+NewtonInterpolator::NewtonInterpolator()
+  : mUpdatesSinceBuild(0)
+{
+}
+
+void NewtonInterpolator::Build(const std::vector<double> &aXs, const std::vector<double> &aYs)
+{
+  mXs.clear();
+  mYs.clear();
+  mCoefficients.clear();
+  mLastRow.clear();
+
+  for (size_t i{ 0 }; i < std::min(aXs.size(), aYs.size()); ++i)
+  {
+    Append(aXs[i], aYs[i]);
+  }
+
+  mUpdatesSinceBuild = 0;
+}
+
+void NewtonInterpolator::Append(double aX, double aY)
+{
+  // The bottom row gains an entry, f[x_n] = y_n, and each entry above it
+  // becomes f[x_i, ..., x_n] in turn. The last of them is the new
+  // coefficient.
+  auto n = mXs.size();
+
+  mXs.push_back(aX);
+  mYs.push_back(aY);
+  mLastRow.push_back(aY);
+
+  for (size_t i{ n }; i > 0; --i)
+  {
+    mLastRow[i - 1] = (mLastRow[i] - mLastRow[i - 1]) / (aX - mXs[i - 1]);
+  }
+
+  mCoefficients.push_back(mLastRow[0]);
+}
+
+void NewtonInterpolator::SetValue(size_t aIndex, double aY)
+{
+  auto n = mXs.size();
+
+  if (++mUpdatesSinceBuild > n)
+  {
+    mYs[aIndex] = aY;
+    auto xs = mXs;
+    auto ys = mYs;
+    Build(xs, ys);
+    return;
+  }
+
+  auto delta = aY - mYs[aIndex];
+  auto x = mXs[aIndex];
+  mYs[aIndex] = aY;
+
+  // c_k = f[x_0, ..., x_k] only involves y_j for k >= j.
+  double weight{ delta };
+
+  for (size_t l{ 0 }; l < aIndex; ++l)
+  {
+    weight /= x - mXs[l];
+  }
+
+  mCoefficients[aIndex] += weight;
+
+  for (size_t k{ aIndex + 1 }; k < n; ++k)
+  {
+    weight /= x - mXs[k];
+    mCoefficients[k] += weight;
+  }
+
+  // f[x_i, ..., x_{n-1}] only involves y_j for i <= j.
+  weight = delta;
+
+  for (size_t l{ aIndex + 1 }; l < n; ++l)
+  {
+    weight /= x - mXs[l];
+  }
+
+  mLastRow[aIndex] += weight;
+
+  for (size_t i{ aIndex }; i > 0; --i)
+  {
+    weight /= x - mXs[i - 1];
+    mLastRow[i - 1] += weight;
+  }
+}
+
+double NewtonInterpolator::Evaluate(double aX) const
+{
+  auto n = mCoefficients.size();
+
+  if (0 == n)
+  {
+    return 0.0;
+  }
+
+  double result = mCoefficients[n - 1];
+
+  for (size_t k{ n - 1 }; k > 0; --k)
+  {
+    result = result * (aX - mXs[k - 1]) + mCoefficients[k - 1];
+  }
+
+  return result;
+}
+
+void NewtonInterpolator::Evaluate(const float *aXs, float *aOut, size_t aCount) const
+{
+  // Each sample's Horner loop is one long chain of dependent multiply-adds,
+  // so a block of them is run side by side to keep the FPU busy.
+  constexpr size_t cBlock = 8;
+
+  auto n = mCoefficients.size();
+  size_t start{ 0 };
+
+  for (; n > 0 && start + cBlock <= aCount; start += cBlock)
+  {
+    double xs[cBlock];
+    double results[cBlock];
+
+    for (size_t s{ 0 }; s < cBlock; ++s)
+    {
+      xs[s] = aXs[start + s];
+      results[s] = mCoefficients[n - 1];
+    }
+
+    for (size_t k{ n - 1 }; k > 0; --k)
+    {
+      for (size_t s{ 0 }; s < cBlock; ++s)
+      {
+        results[s] = results[s] * (xs[s] - mXs[k - 1]) + mCoefficients[k - 1];
+      }
+    }
+
+    for (size_t s{ 0 }; s < cBlock; ++s)
+    {
+      aOut[start + s] = static_cast<float>(results[s]);
+    }
+  }
+
+  for (size_t i{ start }; i < aCount; ++i)
+  {
+    aOut[i] = static_cast<float>(Evaluate(aXs[i]));
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// BarycentricInterpolator
+///////////////////////////////////////////////////////////////////////////////////
+void BarycentricInterpolator::SetNodes(const std::vector<double> &aXs)
+{
+  // Each weight is one long chain of multiplies, so a block of them is
+  // worked out side by side like NewtonInterpolator::Evaluate.
+  constexpr size_t cBlock = 8;
+
+  // The products under or overflow a double long before n gets interesting,
+  // so their exponents are split off every so often and only the
+  // differences between them are kept.
+  constexpr size_t cRenormalizeEvery = 16;
+
+  auto n = aXs.size();
+
+  mXs = aXs;
+  mYs.resize(n, 0.0);
+  mWeights.resize(n);
+
+  std::vector<int> exponents(n);
+  int largestExponent{ std::numeric_limits<int>::min() };
+
+  for (size_t start{ 0 }; start < n; start += cBlock)
+  {
+    double xs[cBlock];
+    double products[cBlock];
+    int blockExponents[cBlock];
+
+    // Spare lanes just repeat the first node.
+    for (size_t s{ 0 }; s < cBlock; ++s)
+    {
+      xs[s] = mXs[(start + s < n) ? start + s : start];
+      products[s] = 1.0;
+      blockExponents[s] = 0;
+    }
+
+    for (size_t j{ 0 }; j < n; j += cRenormalizeEvery)
+    {
+      auto end = std::min(j + cRenormalizeEvery, n);
+
+      for (size_t k{ j }; k < end; ++k)
+      {
+        for (size_t s{ 0 }; s < cBlock; ++s)
+        {
+          // The only zero is the node itself, the xs being distinct.
+          auto difference = xs[s] - mXs[k];
+          products[s] *= (0.0 == difference) ? 1.0 : difference;
+        }
+      }
+
+      for (size_t s{ 0 }; s < cBlock; ++s)
+      {
+        int split;
+        products[s] = std::frexp(products[s], &split);
+        blockExponents[s] += split;
+      }
+    }
+
+    for (size_t s{ 0 }; s < cBlock && start + s < n; ++s)
+    {
+      mWeights[start + s] = 1.0 / products[s];
+      exponents[start + s] = -blockExponents[s];
+      largestExponent = std::max(largestExponent, -blockExponents[s]);
+    }
+  }
+
+  for (size_t i{ 0 }; i < n; ++i)
+  {
+    mWeights[i] = std::ldexp(mWeights[i], exponents[i] - largestExponent);
+  }
+}
+
+void BarycentricInterpolator::SetValues(const std::vector<double> &aYs)
+{
+  std::copy_n(aYs.begin(), std::min(aYs.size(), mYs.size()), mYs.begin());
+}
+
+double BarycentricInterpolator::Evaluate(double aX) const
+{
+  double numerator{ 0.0 };
+  double denominator{ 0.0 };
+
+  for (size_t i{ 0 }; i < mXs.size(); ++i)
+  {
+    auto difference = aX - mXs[i];
+
+    // The formula is 0 / 0 on a node, but the answer is known.
+    if (0.0 == difference)
+    {
+      return mYs[i];
+    }
+
+    auto term = mWeights[i] / difference;
+    numerator += term * mYs[i];
+    denominator += term;
+  }
+
+  return (0.0 == denominator) ? 0.0 : numerator / denominator;
+}
+
+void BarycentricInterpolator::Evaluate(const float *aXs, float *aOut, size_t aCount) const
+{
+  // One division per node and sample either way, run a block of samples
+  // side by side so they overlap.
+  constexpr size_t cBlock = 8;
+
+  auto n = mXs.size();
+  size_t start{ 0 };
+
+  for (; n > 0 && start + cBlock <= aCount; start += cBlock)
+  {
+    double xs[cBlock];
+    double numerators[cBlock];
+    double denominators[cBlock];
+    size_t exact[cBlock];
+
+    for (size_t s{ 0 }; s < cBlock; ++s)
+    {
+      xs[s] = aXs[start + s];
+      numerators[s] = 0.0;
+      denominators[s] = 0.0;
+      exact[s] = n;
+    }
+
+    for (size_t i{ 0 }; i < n; ++i)
+    {
+      for (size_t s{ 0 }; s < cBlock; ++s)
+      {
+        auto difference = xs[s] - mXs[i];
+        auto term = mWeights[i] / difference;
+
+        // Samples on a node are answered afterwards, the sums are junk.
+        exact[s] = (0.0 == difference) ? i : exact[s];
+        numerators[s] += term * mYs[i];
+        denominators[s] += term;
+      }
+    }
+
+    for (size_t s{ 0 }; s < cBlock; ++s)
+    {
+      auto result = (n != exact[s])          ? mYs[exact[s]] :
+                    (0.0 == denominators[s]) ? 0.0 :
+                                               numerators[s] / denominators[s];
+
+      aOut[start + s] = static_cast<float>(result);
+    }
+  }
+
+  for (size_t i{ start }; i < aCount; ++i)
+  {
+    aOut[i] = static_cast<float>(Evaluate(aXs[i]));
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// CubicSpline
+///////////////////////////////////////////////////////////////////////////////////
+void CubicSpline::SetKnots(const std::vector<double> &aXs, SplineEnd aEnd)
+{
+  auto n = aXs.size();
+
+  mXs = aXs;
+  mEnd = aEnd;
+  mYs.assign(n, 0.0);
+  mMoments.assign(n, 0.0);
+  mLower.assign(n, 0.0);
+  mUpper.assign(n, 0.0);
+  mInversePivot.assign(n, 1.0);
+  mInverseWidths.resize((n > 0) ? n - 1 : 0);
+  mSolved = false;
+
+  if (n < 2)
+  {
+    return;
+  }
+
+  for (size_t i{ 0 }; i + 1 < n; ++i)
+  {
+    mInverseWidths[i] = 1.0 / (mXs[i + 1] - mXs[i]);
+  }
+
+  // Row i of the system is
+  //   h[i-1] M[i-1] + 2 (h[i-1] + h[i]) M[i] + h[i] M[i+1] = rhs[i]
+  // with h[i] = x[i+1] - x[i]. The end rows either pin M to zero or match
+  // the end slopes.
+  auto row = [&](size_t i, double &aBelow, double &aDiagonal, double &aAbove)
+  {
+    auto left = (i > 0) ? mXs[i] - mXs[i - 1] : 0.0;
+    auto right = (i + 1 < n) ? mXs[i + 1] - mXs[i] : 0.0;
+
+    if ((0 == i || n - 1 == i) && SplineEnd::Natural == mEnd)
+    {
+      aBelow = 0.0;
+      aDiagonal = 1.0;
+      aAbove = 0.0;
+      return;
+    }
+
+    aBelow = left;
+    aDiagonal = 2.0 * (left + right);
+    aAbove = right;
+  };
+
+  double below, diagonal, above;
+  double upperAbove{ 0.0 };
+
+  for (size_t i{ 0 }; i < n; ++i)
+  {
+    row(i, below, diagonal, above);
+
+    auto pivot = diagonal - below * upperAbove;
+
+    mInversePivot[i] = 1.0 / pivot;
+    mLower[i] = below * mInversePivot[i];
+    mUpper[i] = above * mInversePivot[i];
+    upperAbove = mUpper[i];
+  }
+}
+
+void CubicSpline::SetValues(const std::vector<double> &aYs)
+{
+  std::copy_n(aYs.begin(), std::min(aYs.size(), mYs.size()), mYs.begin());
+  mSolved = false;
+}
+
+void CubicSpline::SetEndSlopes(double aStart, double aEnd)
+{
+  if (mStartSlope != aStart || mEndSlope != aEnd)
+  {
+    mStartSlope = aStart;
+    mEndSlope = aEnd;
+    mSolved = (SplineEnd::Clamped == mEnd) ? false : mSolved;
+  }
+}
+
+void CubicSpline::Solve()
+{
+  auto n = mXs.size();
+
+  if (mSolved || n < 2)
+  {
+    mSolved = true;
+    return;
+  }
+
+  // The right hand side is
+  //   6 (s[i] - s[i-1])
+  // for the slopes s[i] of the chords, worked out as the forward sweep goes
+  // with the cached pivots. Then back substitute in place.
+  auto natural = SplineEnd::Natural == mEnd;
+  auto slope = (mYs[1] - mYs[0]) * mInverseWidths[0];
+  auto previous = (natural ? 0.0 : 6.0 * (slope - mStartSlope)) * mInversePivot[0];
+
+  mMoments[0] = previous;
+
+  for (size_t i{ 1 }; i + 1 < n; ++i)
+  {
+    auto nextSlope = (mYs[i + 1] - mYs[i]) * mInverseWidths[i];
+
+    previous = 6.0 * (nextSlope - slope) * mInversePivot[i] - mLower[i] * previous;
+    mMoments[i] = previous;
+    slope = nextSlope;
+  }
+
+  auto last = natural ? 0.0 : 6.0 * (mEndSlope - slope);
+  mMoments[n - 1] = last * mInversePivot[n - 1] - mLower[n - 1] * previous;
+
+  for (size_t i{ n - 1 }; i > 0; --i)
+  {
+    mMoments[i - 1] -= mUpper[i - 1] * mMoments[i];
+  }
+
+  mSolved = true;
+}
+
+double CubicSpline::Evaluate(double aX) const
+{
+  auto n = mXs.size();
+
+  if (n < 2)
+  {
+    return (1 == n) ? mYs[0] : 0.0;
+  }
+
+  // The piece whose knots surround aX, or the end ones to extrapolate.
+  auto after = std::upper_bound(mXs.begin(), mXs.end(), aX) - mXs.begin();
+  auto i = static_cast<size_t>(std::clamp<std::ptrdiff_t>(after - 1, 0, static_cast<std::ptrdiff_t>(n) - 2));
+
+  auto h = mXs[i + 1] - mXs[i];
+  auto a = (mXs[i + 1] - aX) * mInverseWidths[i];
+  auto b = (aX - mXs[i]) * mInverseWidths[i];
+
+  return a * mYs[i] + b * mYs[i + 1] +
+         ((a * a * a - a) * mMoments[i] + (b * b * b - b) * mMoments[i + 1]) * (h * h) / 6.0;
+}
+
+void CubicSpline::Evaluate(const float *aXs, float *aOut, size_t aCount) const
+{
+  for (size_t i{ 0 }; i < aCount; ++i)
+  {
+    aOut[i] = static_cast<float>(Evaluate(aXs[i]));
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Picking
+///////////////////////////////////////////////////////////////////////////////////
+int PickControlPoint(const std::vector<float> &aYs, glm::vec2 aPosition, float aRadius)
+{
+  if (aYs.empty())
+  {
+    return -1;
+  }
+
+  auto last = static_cast<float>(aYs.size() - 1);
+  float spacing = (0.0f == last) ? 1.0f : 1.0f / last;
+
+  // Indices whose x is within the radius, clamped to the points we have.
+  auto first = std::ceil((aPosition.x - aRadius) * last);
+  auto end = std::floor((aPosition.x + aRadius) * last);
+
+  if (end < 0.0f || first > last)
+  {
+    return -1;
+  }
+
+  auto firstIndex = static_cast<long long>(std::max(first, 0.0f));
+  auto endIndex = static_cast<long long>(std::min(end, last));
+
+  // Walk outwards from the point closest in x, so once a hit is found both
+  // directions can stop as soon as x alone is further away than it.
+  auto nearest = std::clamp(static_cast<long long>(std::round(aPosition.x * last)), firstIndex, endIndex);
+
+  int closest{ -1 };
+  float closestDistanceSquared = aRadius * aRadius;
+
+  auto test = [&](long long aIndex)
+  {
+    auto dx = aIndex * spacing - aPosition.x;
+
+    if (dx * dx > closestDistanceSquared)
+    {
+      return false;
+    }
+
+    auto dy = aYs[static_cast<size_t>(aIndex)] - aPosition.y;
+    auto distanceSquared = dx * dx + dy * dy;
+
+    if (distanceSquared <= closestDistanceSquared)
+    {
+      closestDistanceSquared = distanceSquared;
+      closest = static_cast<int>(aIndex);
+    }
+
+    return true;
+  };
+
+  test(nearest);
+
+  for (auto i{ nearest + 1 }; i <= endIndex && test(i); ++i)
+  {
+  }
+
+  for (auto i{ nearest - 1 }; i >= firstIndex && test(i); --i)
+  {
+  }
+
+  return closest;
+}
+
+int PickControlPoint(const std::vector<float> &aYs,
+                     const std::vector<float> &aXs,
+                     glm::vec2 aPosition,
+                     float aRadius)
+{
+  auto count = static_cast<long long>(std::min(aXs.size(), aYs.size()));
+
+  if (0 == count)
+  {
+    return -1;
+  }
+
+  // Same outward walk as above, only the x range comes from a search.
+  auto begin = aXs.begin();
+  auto firstIndex = static_cast<long long>(std::lower_bound(begin, begin + count, aPosition.x - aRadius) - begin);
+  auto endIndex = static_cast<long long>(std::upper_bound(begin, begin + count, aPosition.x + aRadius) - begin) - 1;
+
+  if (firstIndex > endIndex)
+  {
+    return -1;
+  }
+
+  auto nearest = std::clamp(static_cast<long long>(std::lower_bound(begin, begin + count, aPosition.x) - begin),
+                            firstIndex,
+                            endIndex);
+
+  int closest{ -1 };
+  float closestDistanceSquared = aRadius * aRadius;
+
+  auto test = [&](long long aIndex)
+  {
+    auto dx = aXs[static_cast<size_t>(aIndex)] - aPosition.x;
+
+    if (dx * dx > closestDistanceSquared)
+    {
+      return false;
+    }
+
+    auto dy = aYs[static_cast<size_t>(aIndex)] - aPosition.y;
+    auto distanceSquared = dx * dx + dy * dy;
+
+    if (distanceSquared <= closestDistanceSquared)
+    {
+      closestDistanceSquared = distanceSquared;
+      closest = static_cast<int>(aIndex);
+    }
+
+    return true;
+  };
+
+  test(nearest);
+
+  for (auto i{ nearest + 1 }; i <= endIndex && test(i); ++i)
+  {
+  }
+
+  for (auto i{ nearest - 1 }; i >= firstIndex && test(i); --i)
+  {
+  }
+
+  return closest;
+}
+
+int PickControlPoint(const BezierControlPolygon &aPolygon, glm::vec2 aPosition, float aRadius)
+{
+  int closest{ -1 };
+  float closestDistanceSquared = aRadius * aRadius;
+
+  for (size_t i{ 0 }; i < aPolygon.Size(); ++i)
+  {
+    auto dx = aPolygon.mX[i] - aPosition.x;
+    auto dy = aPolygon.mY[i] - aPosition.y;
+    auto distanceSquared = dx * dx + dy * dy;
+
+    if (distanceSquared <= closestDistanceSquared)
+    {
+      closestDistanceSquared = distanceSquared;
+      closest = static_cast<int>(i);
+    }
+  }
+
+  return closest;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// AdaptiveTessellator
+///////////////////////////////////////////////////////////////////////////////////
+AdaptiveTessellator::AdaptiveTessellator()
+  : mInitialSegments(16)
+  , mMaxDepth(12)
+{
+}
+
+static glm::vec2 ToScreen(const ScreenMapping &aMapping, glm::vec2 aPoint)
+{
+  auto clip = aMapping.mModelViewProjection * glm::vec4{ aPoint, 0.0f, 1.0f };
+  glm::vec2 ndc{ clip.x / clip.w, clip.y / clip.w };
+
+  return (ndc * 0.5f + 0.5f) * aMapping.mViewportSize;
+}
+
+static bool IsFlat(const ScreenMapping &aMapping,
+                   glm::vec2 aStart,
+                   glm::vec2 aMiddle,
+                   glm::vec2 aEnd)
+{
+  auto start = ToScreen(aMapping, aStart);
+  auto middle = ToScreen(aMapping, aMiddle);
+  auto end = ToScreen(aMapping, aEnd);
+
+  // Entirely off one side of the screen, nobody will see the facets.
+  auto &size = aMapping.mViewportSize;
+  auto lowest = glm::min(glm::min(start, middle), end);
+  auto highest = glm::max(glm::max(start, middle), end);
+
+  if (highest.x < 0.0f || highest.y < 0.0f || lowest.x > size.x || lowest.y > size.y)
+  {
+    return true;
+  }
+
+  // Distance from the middle to the line through the chord.
+  auto chord = end - start;
+  auto toMiddle = middle - start;
+  auto lengthSquared = glm::dot(chord, chord);
+  float distanceSquared;
+
+  if (lengthSquared < 1e-12f)
+  {
+    distanceSquared = glm::dot(toMiddle, toMiddle);
+  }
+  else
+  {
+    auto cross = chord.x * toMiddle.y - chord.y * toMiddle.x;
+    distanceSquared = (cross * cross) / lengthSquared;
+  }
+
+  return distanceSquared <= aMapping.mPixelTolerance * aMapping.mPixelTolerance;
+}
+
+bool AdaptiveTessellator::Tessellate(const CurveSampler &aSampler,
+                                     const ScreenMapping &aMapping,
+                                     std::vector<glm::vec2> &aOut,
+                                     const CancelCheck &aCancelled)
+{
+  auto segments = std::max<size_t>(mInitialSegments, 1);
+
+  UniformSamples(segments + 1, mTs);
+  mYs.resize(mTs.size());
+  aSampler(mTs.data(), mYs.data(), mTs.size());
+
+  aOut.clear();
+
+  for (size_t i{ 0 }; i < mTs.size(); ++i)
+  {
+    aOut.emplace_back(mTs[i], mYs[i]);
+  }
+
+  mActive.assign(segments, true);
+
+  for (size_t depth{ 0 }; depth < mMaxDepth; ++depth)
+  {
+    if (aCancelled && aCancelled())
+    {
+      return false;
+    }
+
+    mTs.clear();
+
+    for (size_t i{ 0 }; i < mActive.size(); ++i)
+    {
+      if (mActive[i])
+      {
+        mTs.push_back(0.5f * (aOut[i].x + aOut[i + 1].x));
+      }
+    }
+
+    if (mTs.empty())
+    {
+      break;
+    }
+
+    mYs.resize(mTs.size());
+    aSampler(mTs.data(), mYs.data(), mTs.size());
+
+    mNextPoints.clear();
+    mNextActive.clear();
+
+    size_t midpoint{ 0 };
+
+    for (size_t i{ 0 }; i < mActive.size(); ++i)
+    {
+      mNextPoints.push_back(aOut[i]);
+
+      if (false == mActive[i])
+      {
+        mNextActive.push_back(false);
+        continue;
+      }
+
+      glm::vec2 middle{ mTs[midpoint], mYs[midpoint] };
+      ++midpoint;
+
+      if (IsFlat(aMapping, aOut[i], middle, aOut[i + 1]))
+      {
+        mNextActive.push_back(false);
+      }
+      else
+      {
+        mNextPoints.push_back(middle);
+        mNextActive.push_back(true);
+        mNextActive.push_back(true);
+      }
+    }
+
+    mNextPoints.push_back(aOut.back());
+
+    std::swap(aOut, mNextPoints);
+    std::swap(mActive, mNextActive);
+  }
+
+  return true;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// BezierSubdivider
+///////////////////////////////////////////////////////////////////////////////////
+void SplitBezier(BezierControlPolygon &aTriangle,
+                 BezierControlPolygon &aLeft,
+                 BezierControlPolygon &aRight,
+                 std::vector<glm::vec3> *aShells)
+{
+  auto n = aTriangle.Size();
+  auto is3D = aTriangle.Is3D();
+
+  for (auto polygon : { &aLeft, &aRight })
+  {
+    polygon->mX.resize(n);
+    polygon->mY.resize(n);
+    polygon->mZ.resize(is3D ? n : 0);
+  }
+
+  if (0 == n)
+  {
+    return;
+  }
+
+  auto store = [&](BezierControlPolygon &aTo, size_t aToIndex, size_t aFromIndex)
+  {
+    aTo.mX[aToIndex] = aTriangle.mX[aFromIndex];
+    aTo.mY[aToIndex] = aTriangle.mY[aFromIndex];
+
+    if (is3D)
+    {
+      aTo.mZ[aToIndex] = aTriangle.mZ[aFromIndex];
+    }
+  };
+
+  store(aLeft, 0, 0);
+  store(aRight, n - 1, n - 1);
+
+  for (size_t k{ 1 }; k < n; ++k)
+  {
+    auto count = n - k;
+
+    // One row of the triangle, a coordinate at a time.
+    for (auto coordinates : { &aTriangle.mX, &aTriangle.mY, &aTriangle.mZ })
+    {
+      if (coordinates->empty())
+      {
+        continue;
+      }
+
+      auto row = coordinates->data();
+
+      for (size_t i{ 0 }; i < count; ++i)
+      {
+        row[i] = 0.5f * (row[i] + row[i + 1]);
+      }
+    }
+
+    store(aLeft, k, 0);
+    store(aRight, count - 1, count - 1);
+
+    if (nullptr != aShells)
+    {
+      for (size_t i{ 0 }; i + 1 < count; ++i)
+      {
+        aShells->push_back(aTriangle.Point(i));
+        aShells->push_back(aTriangle.Point(i + 1));
+      }
+    }
+  }
+}
+
+BezierSubdivider::BezierSubdivider()
+  : mMaxDepth(16)
+  , mPieceCount(0)
+{
+}
+
+static glm::vec2 ToScreen(const ScreenMapping &aMapping, glm::vec3 aPoint)
+{
+  auto clip = aMapping.mModelViewProjection * glm::vec4{ aPoint, 1.0f };
+  glm::vec2 ndc{ clip.x / clip.w, clip.y / clip.w };
+
+  return (ndc * 0.5f + 0.5f) * aMapping.mViewportSize;
+}
+
+bool BezierSubdivider::IsFlat(const BezierControlPolygon &aPolygon, const ScreenMapping &aMapping)
+{
+  auto size = aPolygon.Size();
+
+  if (size <= 2)
+  {
+    return true;
+  }
+
+  auto start = ToScreen(aMapping, aPolygon.Point(0));
+  auto end = ToScreen(aMapping, aPolygon.Point(size - 1));
+  auto chord = end - start;
+  auto lengthSquared = glm::dot(chord, chord);
+
+  auto lowest = glm::min(start, end);
+  auto highest = glm::max(start, end);
+  float furthestSquared{ 0.0f };
+
+  for (size_t i{ 1 }; i < size - 1; ++i)
+  {
+    auto point = ToScreen(aMapping, aPolygon.Point(i));
+    auto toPoint = point - start;
+
+    lowest = glm::min(lowest, point);
+    highest = glm::max(highest, point);
+
+    float distanceSquared;
+
+    if (lengthSquared < 1e-12f)
+    {
+      distanceSquared = glm::dot(toPoint, toPoint);
+    }
+    else
+    {
+      auto cross = chord.x * toPoint.y - chord.y * toPoint.x;
+      distanceSquared = (cross * cross) / lengthSquared;
+    }
+
+    furthestSquared = std::max(furthestSquared, distanceSquared);
+  }
+
+  // The curve stays inside its control polygon's hull, so if that's off
+  // screen nobody will see the facets.
+  auto &viewport = aMapping.mViewportSize;
+
+  if (highest.x < 0.0f || highest.y < 0.0f || lowest.x > viewport.x || lowest.y > viewport.y)
+  {
+    return true;
+  }
+
+  return furthestSquared <= aMapping.mPixelTolerance * aMapping.mPixelTolerance;
+}
+
+void BezierSubdivider::Push(size_t aDepth)
+{
+  if (mPieceCount == mPieces.size())
+  {
+    mPieces.emplace_back();
+  }
+
+  mPieces[mPieceCount++].mDepth = aDepth;
+}
+
+void BezierSubdivider::Subdivide(const BezierControlPolygon &aPolygon,
+                                 const ScreenMapping &aMapping,
+                                 std::vector<glm::vec3> &aOut,
+                                 std::vector<glm::vec3> *aShells,
+                                 size_t aShellDepth)
+{
+  aOut.clear();
+
+  if (0 == aPolygon.Size())
+  {
+    return;
+  }
+
+  mPieceCount = 0;
+  Push(0);
+  mPieces[0].mPolygon = aPolygon;
+
+  while (0 < mPieceCount)
+  {
+    // Copied out, the halves are pushed over the top of it.
+    auto depth = mPieces[mPieceCount - 1].mDepth;
+    std::swap(mRow, mPieces[--mPieceCount].mPolygon);
+
+    auto n = mRow.Size();
+    auto recordShells = nullptr != aShells && depth < aShellDepth;
+
+    if (recordShells)
+    {
+      for (size_t i{ 0 }; i + 1 < n; ++i)
+      {
+        aShells->push_back(mRow.Point(i));
+        aShells->push_back(mRow.Point(i + 1));
+      }
+    }
+
+    if (depth >= mMaxDepth || IsFlat(mRow, aMapping))
+    {
+      aOut.push_back(mRow.Point(0));
+      continue;
+    }
+
+    // Right goes on first, so the left half is finished first and the
+    // vertices come out in order.
+    Push(depth + 1);
+    Push(depth + 1);
+
+    SplitBezier(mRow,
+                mPieces[mPieceCount - 1].mPolygon,
+                mPieces[mPieceCount - 2].mPolygon,
+                recordShells ? aShells : nullptr);
+  }
+
+  aOut.push_back(aPolygon.Point(aPolygon.Size() - 1));
+}
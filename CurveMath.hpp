@@ -0,0 +1,486 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <utility>
+#include <vector>
+
+#include "glm/glm.hpp"
+
+#include "DeCasteljauKernels.hpp"
+
+size_t factorial(size_t n);
+
+// Single Bernstein basis function B(d, i, t). Evaluated in log space so it
+// doesn't overflow for large d, and safe to call from any thread. Prefer
+// BernsteinBasis when you need every i.
+float BernstienPolynomial(size_t d, size_t i, float t);
+
+// Evaluates the full Bernstein basis of a degree for a given t.
+//
+// The binomial coefficients are precomputed once per degree as logarithms,
+// since C(d, i) overflows a double somewhere past d = 1000. Evaluation
+// anchors on the largest basis value (near i = d * t) and walks outwards
+// with the ratio B(i + 1) / B(i), so it's O(d) per t and never has to
+// represent anything larger than 1.
+class BernsteinBasis
+{
+public:
+  BernsteinBasis();
+
+  // Rebuilds the binomial table, does nothing if the degree is unchanged.
+  void SetDegree(size_t aDegree);
+  size_t GetDegree() const { return mDegree; }
+
+  // Writes all d + 1 basis values for aT into aBasis. Values too small to
+  // matter are left at zero without being computed, the rest fall in the
+  // returned [first, last] range.
+  std::pair<size_t, size_t> Evaluate(double aT, double *aBasis) const;
+
+  // Sum of aCoefficients[i] * B(d, i, aT), where d + 1 coefficients are read.
+  float Evaluate(const float *aCoefficients, float aT);
+
+private:
+  std::vector<double> mLogBinomials;
+
+  // (d - i) / (i + 1) and i / (d - i + 1), the ratios between neighbouring
+  // binomials, so walking the basis needs no divisions.
+  std::vector<double> mUpFactors;
+  std::vector<double> mDownFactors;
+  std::vector<double> mBasis;
+  size_t mDegree;
+};
+
+// Fills aTs with aCount evenly spaced parameter values covering [0, 1].
+void UniformSamples(size_t aCount, std::vector<float> &aTs);
+
+// Evaluates the polynomial with Bernstein coefficients aCoefficients at each
+// of aTs using the de Casteljau triangle, writing the results to aOut. aTs
+// and aOut may be the same array.
+//
+// Samples are processed in blocks stored as structure of arrays in
+// aScratch, so each lerp of the triangle runs over contiguous samples and
+// the control polygon is only read once per block. The kernel is picked from
+// the best SIMD level the CPU supports unless one is given.
+void EvaluateDeCasteljau(const float *aCoefficients,
+                         size_t aCoefficientCount,
+                         const float *aTs,
+                         float *aOut,
+                         size_t aSampleCount,
+                         std::vector<float> &aScratch);
+
+void EvaluateDeCasteljau(const float *aCoefficients,
+                         size_t aCoefficientCount,
+                         const float *aTs,
+                         float *aOut,
+                         size_t aSampleCount,
+                         std::vector<float> &aScratch,
+                         SimdLevel aLevel);
+
+// Evaluates samples [aFirst, aFirst + aCount) of the aSampleCount evenly
+// spaced samples UniformSamples would produce, by forward differencing.
+//
+// Once the d + 1 differences of a degree d polynomial are known at one
+// sample, each following sample is just d additions. The error compounds
+// with every step though, and much faster the higher the degree, so every
+// aAnchorInterval samples the table is rebuilt from d + 1 samples evaluated
+// exactly. A rebuild costs O(d^3), so this only pays off for low degrees.
+// Pass 0 to pick the interval from the degree, see
+// ForwardDifferenceAnchorInterval.
+//
+// Anchoring at aFirst means separate ranges can be evaluated in parallel.
+void EvaluateForwardDifferences(const float *aCoefficients,
+                                size_t aCoefficientCount,
+                                size_t aFirst,
+                                size_t aCount,
+                                size_t aSampleCount,
+                                float *aOut,
+                                size_t aAnchorInterval,
+                                std::vector<double> &aScratch);
+
+// Longest run of samples a degree aDegree table can be stepped through
+// while the accumulated error stays around float precision. Never less than
+// aDegree + 1, at which point everything is evaluated exactly.
+size_t ForwardDifferenceAnchorInterval(size_t aDegree);
+
+// Past this degree re-anchoring costs more than forward differencing saves,
+// and even the scalar de Casteljau kernel is faster. Measured at 65536
+// samples: degree 3 is twice as fast as any kernel, degree 4 about breaks
+// even with AVX2, degree 5 loses to scalar and it only gets worse from there.
+constexpr size_t cForwardDifferenceMaxDegree = 4;
+
+///////////////////////////////////////////////////////////////////////////////////
+// Bezier Curves
+///////////////////////////////////////////////////////////////////////////////////
+
+// Control polygon of a Bezier curve, kept as a structure of arrays so every
+// coordinate is its own run of floats and goes through the same blocked
+// de Casteljau kernels as a polynomial function. mZ is empty for 2D curves.
+struct BezierControlPolygon
+{
+  size_t Size() const { return mX.size(); }
+  bool Is3D() const { return false == mZ.empty(); }
+
+  glm::vec3 Point(size_t aIndex) const
+  {
+    return { mX[aIndex], mY[aIndex], Is3D() ? mZ[aIndex] : 0.0f };
+  }
+
+  std::vector<float> mX;
+  std::vector<float> mY;
+  std::vector<float> mZ;
+};
+
+// Past this many control points a Bezier curve is evaluated from the
+// Bernstein basis instead of the de Casteljau triangle.
+constexpr size_t cBezierBasisThreshold = 64;
+
+// Batch evaluation of Bezier curves, one coordinate at a time.
+//
+// Small polygons go through EvaluateDeCasteljau once per coordinate. The
+// triangle is O(n^2) per sample though, which rules out thousands of
+// points, so larger ones evaluate the O(n) BernsteinBasis once per t and
+// dot it with each coordinate array in turn. The members are only scratch.
+class BezierEvaluator
+{
+public:
+  // Evaluates the curve at each of aTs, writing the coordinates to aOutX,
+  // aOutY and aOutZ. aOutZ is only written for 3D curves and may be null
+  // otherwise.
+  void Evaluate(const BezierControlPolygon &aPolygon,
+                const float *aTs,
+                size_t aCount,
+                float *aOutX,
+                float *aOutY,
+                float *aOutZ);
+
+private:
+  std::vector<float> mScratch;
+  BernsteinBasis mBasis;
+  std::vector<double> mBasisValues;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Adaptive Tessellation
+///////////////////////////////////////////////////////////////////////////////////
+
+// Where a curve ends up on screen, and how far (in pixels) a line segment is
+// allowed to stray from it.
+struct ScreenMapping
+{
+  glm::mat4 mModelViewProjection;
+  glm::vec2 mViewportSize;
+  float mPixelTolerance;
+};
+
+inline bool operator==(const ScreenMapping &aLeft, const ScreenMapping &aRight)
+{
+  return aLeft.mModelViewProjection == aRight.mModelViewProjection &&
+         aLeft.mViewportSize == aRight.mViewportSize &&
+         aLeft.mPixelTolerance == aRight.mPixelTolerance;
+}
+
+inline bool operator!=(const ScreenMapping &aLeft, const ScreenMapping &aRight)
+{
+  return !(aLeft == aRight);
+}
+
+// Evaluates y = f(t) for aCount parameter values at once.
+using CurveSampler = std::function<void(const float *aTs, float *aYs, size_t aCount)>;
+
+// Polled during long running work, returning true abandons it.
+using CancelCheck = std::function<bool()>;
+
+// Tessellates the graph (t, f(t)) over t in [0, 1] by splitting segments
+// whose midpoint is further than the pixel tolerance from their chord once
+// projected to the screen. Flat or offscreen stretches end up as a handful
+// of vertices, curvy ones are split until they stop faceting.
+//
+// Each round of splitting evaluates every new midpoint in a single call to
+// the sampler, so batch evaluators are still used to their full extent.
+class AdaptiveTessellator
+{
+public:
+  AdaptiveTessellator();
+
+  // Returns false if aCancelled asked to stop, aOut is left partially
+  // tessellated in that case. It's checked between rounds of splitting.
+  bool Tessellate(const CurveSampler &aSampler,
+                  const ScreenMapping &aMapping,
+                  std::vector<glm::vec2> &aOut,
+                  const CancelCheck &aCancelled = nullptr);
+
+  // Uniform segments to start with, keeps features narrower than a
+  // single segment from being stepped over.
+  size_t mInitialSegments;
+
+  // Each initial segment is split at most this many times.
+  size_t mMaxDepth;
+
+private:
+  std::vector<glm::vec2> mNextPoints;
+  std::vector<float> mTs;
+  std::vector<float> mYs;
+  std::vector<bool> mActive;
+  std::vector<bool> mNextActive;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Bezier Subdivision
+///////////////////////////////////////////////////////////////////////////////////
+
+// Splits a Bezier curve at t = 0.5 with one pass of the de Casteljau
+// triangle: aLeft is the [0, 0.5] half and aRight the [0.5, 1] half, each
+// with as many control points as the original. The triangle is computed in
+// place in aTriangle, which is left holding its last row. If aShells is
+// given, the rows below the control polygon are added to it as pairs of
+// line end points.
+void SplitBezier(BezierControlPolygon &aTriangle,
+                 BezierControlPolygon &aLeft,
+                 BezierControlPolygon &aRight,
+                 std::vector<glm::vec3> *aShells = nullptr);
+
+// Tessellates a Bezier curve by splitting it in half until each piece's
+// control polygon is flat once projected to the screen. By the convex hull
+// property a flat polygon means the curve is within the pixel tolerance of
+// the chord, so each piece contributes just its end points.
+//
+// A split at t = 0.5 is one pass of the de Casteljau triangle, which gives
+// both halves' control points at once: the left half runs down its first
+// column and the right half back up its diagonal. The rows in between are
+// the shells that show the construction, so they can be handed out as they
+// are computed rather than evaluated again.
+class BezierSubdivider
+{
+public:
+  BezierSubdivider();
+
+  // Writes the curve's vertices to aOut. If aShells is given, the shells of
+  // every split shallower than aShellDepth are added to it as pairs of line
+  // end points, starting with the control polygon itself.
+  void Subdivide(const BezierControlPolygon &aPolygon,
+                 const ScreenMapping &aMapping,
+                 std::vector<glm::vec3> &aOut,
+                 std::vector<glm::vec3> *aShells = nullptr,
+                 size_t aShellDepth = 1);
+
+  // Pieces are split at most this many times, every split costs O(n^2).
+  size_t mMaxDepth;
+
+private:
+  bool IsFlat(const BezierControlPolygon &aPolygon, const ScreenMapping &aMapping);
+  void Push(size_t aDepth);
+
+  struct Piece
+  {
+    BezierControlPolygon mPolygon;
+    size_t mDepth;
+  };
+
+  // Pieces waiting to be split, only [0, mPieceCount) are live. The rest
+  // keep their storage around for the next push.
+  std::vector<Piece> mPieces;
+  size_t mPieceCount;
+
+  // The triangle is computed in place in here, a row at a time.
+  BezierControlPolygon mRow;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Polynomial Interpolation
+///////////////////////////////////////////////////////////////////////////////////
+
+// The polynomial through (x_i, y_i), in Newton form:
+//   p(x) = c_0 + c_1 (x - x_0) + ... + c_n (x - x_0)...(x - x_{n-1})
+// where c_k = f[x_0, ..., x_k] are the divided differences along the top of
+// the table.
+//
+// Divided differences are linear in the ys, so when y_j moves by delta,
+// f[x_i, ..., x_k] moves by delta / prod_{l != j} (x_j - x_l) over the same
+// nodes. Consecutive entries differ by one factor, so the top of the table
+// and its bottom row (f[x_i, ..., x_{n-1}], all that appending needs) are
+// both updated in O(n) rather than rebuilt in O(n^2). Every update adds a
+// little rounding error, so after n of them the table is rebuilt, still
+// O(n) amortised.
+class NewtonInterpolator
+{
+public:
+  NewtonInterpolator();
+
+  // Starts over with the given nodes, O(n^2). The xs must be distinct.
+  void Build(const std::vector<double> &aXs, const std::vector<double> &aYs);
+
+  // Adds a node after the last one, O(n).
+  void Append(double aX, double aY);
+
+  // Moves node aIndex to aY, O(n).
+  void SetValue(size_t aIndex, double aY);
+
+  // Nested, Horner style evaluation, O(n).
+  double Evaluate(double aX) const;
+  void Evaluate(const float *aXs, float *aOut, size_t aCount) const;
+
+  size_t Size() const { return mXs.size(); }
+  const std::vector<double>& Xs() const { return mXs; }
+  const std::vector<double>& Ys() const { return mYs; }
+  const std::vector<double>& Coefficients() const { return mCoefficients; }
+
+  // SetValue calls since the last full Build.
+  size_t UpdatesSinceBuild() const { return mUpdatesSinceBuild; }
+
+private:
+  std::vector<double> mXs;
+  std::vector<double> mYs;
+  std::vector<double> mCoefficients;
+  std::vector<double> mLastRow;
+  size_t mUpdatesSinceBuild;
+};
+
+// The polynomial through (x_i, y_i) in the second (true) barycentric form:
+//   p(x) = sum(w_i y_i / (x - x_i)) / sum(w_i / (x - x_i))
+// with w_i = 1 / prod_{j != i} (x_i - x_j).
+//
+// The weights only depend on the xs, so they're worked out once per node set
+// in O(n^2). After that every sample is O(n) and moving a y costs nothing
+// more than storing it. Any common factor of the weights cancels, so they're
+// kept scaled so the largest is around one, which is what lets hundreds of
+// nodes work without overflowing. With Chebyshev nodes that stays accurate
+// at high degrees, where the Newton form falls apart.
+class BarycentricInterpolator
+{
+public:
+  // O(n^2), the xs must be distinct.
+  void SetNodes(const std::vector<double> &aXs);
+
+  // O(n), the values for the current nodes.
+  void SetValues(const std::vector<double> &aYs);
+
+  // O(1).
+  void SetValue(size_t aIndex, double aY) { mYs[aIndex] = aY; }
+
+  double Evaluate(double aX) const;
+  void Evaluate(const float *aXs, float *aOut, size_t aCount) const;
+
+  size_t Size() const { return mXs.size(); }
+  const std::vector<double>& Xs() const { return mXs; }
+  const std::vector<double>& Ys() const { return mYs; }
+  const std::vector<double>& Weights() const { return mWeights; }
+
+private:
+  std::vector<double> mXs;
+  std::vector<double> mYs;
+  std::vector<double> mWeights;
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Cubic Splines
+///////////////////////////////////////////////////////////////////////////////////
+enum class SplineEnd : int
+{
+  // No curvature at the ends.
+  Natural = 0,
+
+  // Given slopes at the ends, see CubicSpline::SetEndSlopes.
+  Clamped = 1
+};
+
+// The C2 cubic spline through (x_i, y_i), found from its second derivatives
+// at the knots, which make a tridiagonal system solved with the Thomas
+// algorithm.
+//
+// The matrix only depends on the xs and the end condition, so it's factored
+// once in SetKnots and kept. Changing values or end slopes just changes the
+// right hand side, and Solve() runs the two O(n) sweeps again without a
+// single division.
+class CubicSpline
+{
+public:
+  // O(n), the xs must be increasing. Values are reset to zero.
+  void SetKnots(const std::vector<double> &aXs, SplineEnd aEnd);
+
+  // O(1) or O(n), none of these solve, call Solve() once they're done.
+  void SetValue(size_t aIndex, double aY) { mYs[aIndex] = aY; mSolved = false; }
+  void SetValues(const std::vector<double> &aYs);
+  void SetEndSlopes(double aStart, double aEnd);
+
+  // O(n) if anything changed since the last one.
+  void Solve();
+
+  // Only meaningful after Solve().
+  double Evaluate(double aX) const;
+  void Evaluate(const float *aXs, float *aOut, size_t aCount) const;
+
+  size_t Size() const { return mXs.size(); }
+  SplineEnd End() const { return mEnd; }
+  const std::vector<double>& Xs() const { return mXs; }
+  const std::vector<double>& Ys() const { return mYs; }
+
+  // Second derivatives at the knots.
+  const std::vector<double>& Moments() const { return mMoments; }
+
+private:
+  std::vector<double> mXs;
+  std::vector<double> mYs;
+  std::vector<double> mMoments;
+
+  // 1 / (x[i+1] - x[i]).
+  std::vector<double> mInverseWidths;
+
+  // The factored system: row i is scaled by mInversePivot[i] then reduced
+  // by mLower[i] times the row above, leaving mUpper[i] above the diagonal.
+  std::vector<double> mLower;
+  std::vector<double> mUpper;
+  std::vector<double> mInversePivot;
+
+  SplineEnd mEnd{ SplineEnd::Natural };
+  double mStartSlope{ 0.0 };
+  double mEndSlope{ 0.0 };
+  bool mSolved{ false };
+};
+
+///////////////////////////////////////////////////////////////////////////////////
+// Picking
+///////////////////////////////////////////////////////////////////////////////////
+
+// Lays out the control points of a function where they're drawn and picked:
+// at aXs if there's one per point, otherwise evenly spaced over [0, 1].
+// aOut is replaced, tPoint only needs to be constructible from a glm::vec3.
+template <typename tPoint>
+void LayoutFunctionPoints(const std::vector<float> &aYs,
+                          const std::vector<float> &aXs,
+                          std::vector<tPoint> &aOut)
+{
+  auto offset = (aYs.size() > 1) ? 1.0f / (aYs.size() - 1) : 0.0f;
+  auto hasXs = aXs.size() == aYs.size();
+
+  aOut.clear();
+  aOut.reserve(aYs.size());
+
+  for (size_t i{ 0 }; i < aYs.size(); ++i)
+  {
+    aOut.emplace_back(glm::vec3{ hasXs ? aXs[i] : i * offset, aYs[i], 0.0f });
+  }
+}
+
+
+// Finds the control point closest to aPosition within aRadius, where control
+// point i sits at (i / (n - 1), aYs[i]), as laid out by
+// PointDrawer::FromYValues. Returns -1 if none are close enough.
+//
+// Since the x positions are fixed by the index, only the points whose x is
+// within aRadius of aPosition are looked at, nearest first, and the search
+// stops as soon as x alone rules the rest out. There's no index to rebuild
+// when points move, they only ever move in y.
+int PickControlPoint(const std::vector<float> &aYs, glm::vec2 aPosition, float aRadius);
+
+// Same again for points at the increasing xs aXs rather than evenly spaced,
+// found with a binary search.
+int PickControlPoint(const std::vector<float> &aYs,
+                     const std::vector<float> &aXs,
+                     glm::vec2 aPosition,
+                     float aRadius);
+
+// Same for points placed anywhere in the xy plane, ignoring z. There's no
+// order to take advantage of, so every point is looked at. Returns -1 if
+// none are close enough.
+int PickControlPoint(const BezierControlPolygon &aPolygon, glm::vec2 aPosition, float aRadius);
@@ -0,0 +1,31 @@
+#pragma once
+
+#include <cstddef>
+
+// Number of samples that share one pass over the control polygon. Must be a
+// multiple of the widest kernel (16 floats for AVX-512).
+constexpr size_t cDeCasteljauBlock = 32;
+
+enum class SimdLevel : int
+{
+  Scalar = 0,
+  SSE2 = 1,
+  AVX2 = 2,
+  AVX512 = 3
+};
+
+const char* ToString(SimdLevel aLevel);
+
+// Highest level both the CPU and the OS support.
+SimdLevel DetectSimdLevel();
+
+// Runs the de Casteljau triangle over one block of cDeCasteljauBlock
+// samples. aRows holds aN + 1 rows of cDeCasteljauBlock floats, on return
+// row 0 holds the result for every sample.
+using DeCasteljauKernel = void(*)(float *aRows,
+                                  const float *aU,
+                                  const float *aOneMinusU,
+                                  size_t aN);
+
+// Returns the kernel for aLevel, or the closest one this CPU can run.
+DeCasteljauKernel GetDeCasteljauKernel(SimdLevel aLevel);
@@ -0,0 +1,228 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+#include "Headless.hpp"
+#include "Profiler.hpp"
+#include "Projects.hpp"
+
+bool ParseHeadlessOptions(int aArgc, char **aArgv, HeadlessOptions &aOptions)
+{
+  bool headless{ false };
+
+  for (int i{ 1 }; i < aArgc; ++i)
+  {
+    auto argument = aArgv[i];
+    bool hasValue = (i + 1) < aArgc;
+
+    if (0 == std::strcmp(argument, "--headless"))
+    {
+      headless = true;
+    }
+    else if (0 == std::strcmp(argument, "--frames") && hasValue)
+    {
+      aOptions.mFrames = std::strtoul(aArgv[++i], nullptr, 10);
+    }
+    else if (0 == std::strcmp(argument, "--points") && hasValue)
+    {
+      aOptions.mControlPoints = std::max(std::atoi(aArgv[++i]), 2);
+    }
+    else if (0 == std::strcmp(argument, "--checksum"))
+    {
+      aOptions.mChecksums = true;
+    }
+    else if (0 == std::strcmp(argument, "--per-frame"))
+    {
+      aOptions.mPerFrame = true;
+    }
+    else if (0 == std::strcmp(argument, "--async"))
+    {
+      aOptions.mAsync = true;
+    }
+    else if (0 == std::strcmp(argument, "--trace") && hasValue)
+    {
+      aOptions.mTracePath = aArgv[++i];
+    }
+  }
+
+  return headless;
+}
+
+// FNV-1a, only needs to notice that the image changed.
+static std::uint64_t Checksum(const std::vector<unsigned char> &aData)
+{
+  std::uint64_t hash{ 14695981039346656037ull };
+
+  for (auto byte : aData)
+  {
+    hash ^= byte;
+    hash *= 1099511628211ull;
+  }
+
+  return hash;
+}
+
+// Drags one control point per frame, walking along the curve, so every frame
+// has to re-evaluate like it would under the mouse.
+static void ScriptFrame(Project &aProject, size_t aFrame)
+{
+  if (aProject.mFreePlacement && aProject.mFreePoints.Size() > 0)
+  {
+    auto &polygon = aProject.mFreePoints;
+    auto dragged = aFrame % polygon.Size();
+
+    polygon.mY[dragged] = 1.5f * std::sin(0.05f * aFrame + dragged);
+    aProject.PointsChanged();
+    return;
+  }
+
+  auto &points = aProject.mPoints;
+  auto dragged = aFrame % points.size();
+
+  points[dragged] = 1.5f * std::sin(0.05f * aFrame + dragged);
+  aProject.PointsChanged();
+}
+
+int RunHeadless(const HeadlessOptions &aOptions)
+{
+  using Clock = std::chrono::high_resolution_clock;
+  using Milliseconds = std::chrono::duration<float, std::milli>;
+
+  GLuint framebuffer;
+  GLuint colorBuffer;
+
+  glGenFramebuffers(1, &framebuffer);
+  glGenRenderbuffers(1, &colorBuffer);
+
+  glBindRenderbuffer(GL_RENDERBUFFER, colorBuffer);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, aOptions.mWidth, aOptions.mHeight);
+
+  glBindFramebuffer(GL_FRAMEBUFFER, framebuffer);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, colorBuffer);
+
+  if (GL_FRAMEBUFFER_COMPLETE != glCheckFramebufferStatus(GL_FRAMEBUFFER))
+  {
+    fprintf(stderr, "Headless: couldn't create the offscreen framebuffer.\n");
+    return 1;
+  }
+
+  printf("GL: %s, %s\n", glGetString(GL_RENDERER), glGetString(GL_VERSION));
+  printf("%zu frames per project, %d control points, %dx%d\n",
+         aOptions.mFrames,
+         aOptions.mControlPoints,
+         aOptions.mWidth,
+         aOptions.mHeight);
+
+  std::vector<float> times;
+  std::vector<unsigned char> pixels;
+
+  for (auto &[name, function] : Project::aProjectFunctions)
+  {
+    Project project;
+    project.mWindowSize = { aOptions.mWidth, aOptions.mHeight };
+    project.mAsyncEvaluation = aOptions.mAsync;
+    project.mControlPoints = aOptions.mControlPoints;
+    project.mPoints.assign(aOptions.mControlPoints, 1.0f);
+    project.PointsChanged();
+
+    times.clear();
+    Profiler::Get().Reset();
+
+    for (size_t frame{ 0 }; frame < aOptions.mFrames; ++frame)
+    {
+      auto frameStart = Clock::now();
+
+      ScriptFrame(project, frame);
+      project.UpdateCamera();
+
+      ImGui_ImplGlfwGL3_NewFrame();
+      ImGui::Begin("Options Window", nullptr);
+      function(project);
+      ImGui::End();
+
+      glViewport(0, 0, aOptions.mWidth, aOptions.mHeight);
+      glClearColor(44 / 255.0f, 44 / 255.0f, 44 / 255.0f, 1.0f);
+      glClear(GL_COLOR_BUFFER_BIT);
+
+      project.RenderAxis();
+
+      ImGui::Render();
+
+      times.push_back(Milliseconds(Clock::now() - frameStart).count());
+      Profiler::Get().EndFrame();
+
+      // Don't let the driver queue up frames, or later frames end up paying
+      // for earlier ones.
+      glFinish();
+
+      if (aOptions.mPerFrame)
+      {
+        printf("  %s, frame %zu: %.3f ms\n", name.c_str(), frame, times.back());
+      }
+    }
+
+    if (times.empty())
+    {
+      continue;
+    }
+
+    auto sorted = times;
+    std::sort(sorted.begin(), sorted.end());
+
+    float sum{ 0.0f };
+
+    for (auto time : times)
+    {
+      sum += time;
+    }
+
+    auto p99 = sorted[std::min(sorted.size() - 1, (sorted.size() * 99) / 100)];
+
+    printf("%s\n  cpu ms: avg %.3f, min %.3f, p99 %.3f, max %.3f\n",
+           name.c_str(),
+           sum / times.size(),
+           sorted.front(),
+           p99,
+           sorted.back());
+
+    // How often the renderer went to the driver for buffer storage, and how
+    // much actually had to be sent, see ShadowBuffer::Update.
+    auto &vertices = project.mRenderer.mVertexBuffer.mShadow;
+    auto &camera = project.mRenderer.mCameraBuffer.mShadow;
+
+    printf("  gpu buffers: %zu allocations, %.1f KB uploaded\n",
+           vertices.Allocations() + camera.Allocations(),
+           (vertices.BytesUploaded() + camera.BytesUploaded()) / 1024.0f);
+
+#if MAT300_PROFILE
+    for (auto &stage : Profiler::Get().Stages())
+    {
+      if (0 != stage.mCount)
+      {
+        printf("    %s: avg %.3f, p99 %.3f\n", stage.mName, stage.Average(), stage.Percentile(99.0f));
+      }
+    }
+#endif
+
+    if (aOptions.mChecksums)
+    {
+      pixels.resize(static_cast<size_t>(aOptions.mWidth) * aOptions.mHeight * 4);
+      glPixelStorei(GL_PACK_ALIGNMENT, 1);
+      glReadPixels(0, 0, aOptions.mWidth, aOptions.mHeight, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+
+      printf("  checksum: %016llx\n", static_cast<unsigned long long>(Checksum(pixels)));
+    }
+  }
+
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  glDeleteRenderbuffers(1, &colorBuffer);
+  glDeleteFramebuffers(1, &framebuffer);
+
+  return 0;
+}
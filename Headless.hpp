@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+
+// Runs every project through a scripted scene without anyone at the
+// keyboard, for benchmarking and regression testing on machines without a
+// GPU or display (Mesa's llvmpipe is fine).
+//
+// Expects a current GL context and an initialized ImGui binding, main sets
+// those up with a hidden window. Everything is drawn into an offscreen
+// framebuffer, so nothing depends on the window actually being shown.
+struct HeadlessOptions
+{
+  // Frames to render per project.
+  size_t mFrames = 120;
+
+  // Control points in the scene.
+  int mControlPoints = 20;
+
+  // Hash the final image of each project, so a change in output shows up
+  // as a change in the checksum.
+  bool mChecksums = false;
+
+  // Print every frame's time, not just the summary.
+  bool mPerFrame = false;
+
+  // Evaluate curves on the worker pool like the app does. Off by default
+  // so every frame draws the curve for its own points.
+  bool mAsync = false;
+
+  // Record a Chrome trace of the run here, see Profiler::BeginTrace.
+  const char *mTracePath = nullptr;
+
+  int mWidth = 1280;
+  int mHeight = 720;
+};
+
+// Parses --headless and its options, returns false if --headless isn't
+// there. Options:
+//   --frames N      Frames to render per project.
+//   --points N      Control points in the scene.
+//   --checksum      Print a checksum of each project's final image.
+//   --per-frame     Print each frame's CPU time.
+//   --async         Evaluate curves in the background.
+//   --trace FILE    Record a trace of every profiled scope to FILE, this
+//                   one works without --headless as well.
+bool ParseHeadlessOptions(int aArgc, char **aArgv, HeadlessOptions &aOptions);
+
+// Returns the exit code for main.
+int RunHeadless(const HeadlessOptions &aOptions);
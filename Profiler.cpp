@@ -0,0 +1,277 @@
+#include <cfloat>
+#include <cstring>
+
+#include <algorithm>
+
+#include "imgui.h"
+
+#include "Profiler.hpp"
+
+///////////////////////////////////////////////////////////////////////////////////
+// Profiler::Stage
+///////////////////////////////////////////////////////////////////////////////////
+float Profiler::Stage::Min() const
+{
+  return (0 == mCount) ? 0.0f : *std::min_element(mHistory, mHistory + mCount);
+}
+
+float Profiler::Stage::Average() const
+{
+  float sum{ 0.0f };
+
+  for (size_t i{ 0 }; i < mCount; ++i)
+  {
+    sum += mHistory[i];
+  }
+
+  return (0 == mCount) ? 0.0f : sum / mCount;
+}
+
+float Profiler::Stage::Percentile(float aPercent) const
+{
+  if (0 == mCount)
+  {
+    return 0.0f;
+  }
+
+  float sorted[cHistory];
+  std::copy_n(mHistory, mCount, sorted);
+
+  auto index = std::min(mCount - 1, static_cast<size_t>(mCount * aPercent / 100.0f));
+  std::nth_element(sorted, sorted + index, sorted + mCount);
+
+  return sorted[index];
+}
+
+float Profiler::Stage::Last() const
+{
+  return (0 == mCount) ? 0.0f : mHistory[(mNext + cHistory - 1) % cHistory];
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Profiler
+///////////////////////////////////////////////////////////////////////////////////
+Profiler& Profiler::Get()
+{
+  static Profiler profiler;
+  return profiler;
+}
+
+size_t Profiler::StageIndex(const char *aName)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (size_t i{ 0 }; i < mStages.size(); ++i)
+  {
+    if (0 == std::strcmp(mStages[i].mName, aName))
+    {
+      return i;
+    }
+  }
+
+  mStages.emplace_back();
+  mStages.back().mName = aName;
+
+  return mStages.size() - 1;
+}
+
+void Profiler::Record(size_t aStage, Clock::time_point aStart, Clock::time_point aEnd)
+{
+  std::chrono::duration<float, std::milli> duration = aEnd - aStart;
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  auto &stage = mStages[aStage];
+  stage.mCurrent += duration.count();
+  stage.mRan = true;
+
+  if (nullptr != mTraceFile)
+  {
+    mTraceEvents.push_back({ aStage, ThreadIndex(), mFrame, aStart, aEnd });
+  }
+}
+
+void Profiler::EndFrame()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  ++mFrame;
+  WriteTraceEvents();
+
+  for (auto &stage : mStages)
+  {
+    if (false == stage.mRan)
+    {
+      continue;
+    }
+
+    stage.mHistory[stage.mNext] = stage.mCurrent;
+    stage.mNext = (stage.mNext + 1) % cHistory;
+    stage.mCount = std::min(stage.mCount + 1, cHistory);
+
+    stage.mCurrent = 0.0f;
+    stage.mRan = false;
+  }
+}
+
+void Profiler::Reset()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  for (auto &stage : mStages)
+  {
+    auto name = stage.mName;
+    stage = Stage{};
+    stage.mName = name;
+  }
+}
+
+std::vector<Profiler::Stage> Profiler::Stages()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return mStages;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Tracing
+///////////////////////////////////////////////////////////////////////////////////
+Profiler::~Profiler()
+{
+  EndTrace();
+}
+
+bool Profiler::BeginTrace(const char *aPath)
+{
+  EndTrace();
+
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  mTraceFile = std::fopen(aPath, "w");
+
+  if (nullptr == mTraceFile)
+  {
+    return false;
+  }
+
+  mTraceStart = Clock::now();
+  mTraceEvents.clear();
+  mFirstTraceEvent = true;
+
+  std::fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n", mTraceFile);
+
+  return true;
+}
+
+void Profiler::EndTrace()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+
+  if (nullptr == mTraceFile)
+  {
+    return;
+  }
+
+  WriteTraceEvents();
+
+  // Name the threads, the first one to record anything is the main loop.
+  for (size_t i{ 0 }; i < mThreads.size(); ++i)
+  {
+    std::fprintf(mTraceFile,
+                 "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":\"%s %zu\"}}",
+                 mFirstTraceEvent ? "" : ",\n",
+                 i,
+                 (0 == i) ? "Main" : "Worker",
+                 i);
+    mFirstTraceEvent = false;
+  }
+
+  std::fputs("\n]}\n", mTraceFile);
+  std::fclose(mTraceFile);
+  mTraceFile = nullptr;
+}
+
+bool Profiler::IsTracing()
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  return nullptr != mTraceFile;
+}
+
+size_t Profiler::ThreadIndex()
+{
+  auto id = std::this_thread::get_id();
+
+  for (size_t i{ 0 }; i < mThreads.size(); ++i)
+  {
+    if (id == mThreads[i])
+    {
+      return i;
+    }
+  }
+
+  mThreads.push_back(id);
+  return mThreads.size() - 1;
+}
+
+// Written as complete ("X") events, a begin and end in one, so nested scopes
+// don't need to be written in begin/end order.
+void Profiler::WriteTraceEvents()
+{
+  if (nullptr == mTraceFile)
+  {
+    return;
+  }
+
+  using Microseconds = std::chrono::duration<double, std::micro>;
+
+  for (auto &event : mTraceEvents)
+  {
+    std::fprintf(mTraceFile,
+                 "%s{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%zu,\"args\":{\"frame\":%zu}}",
+                 mFirstTraceEvent ? "" : ",\n",
+                 mStages[event.mStage].mName,
+                 Microseconds(event.mStart - mTraceStart).count(),
+                 Microseconds(event.mEnd - event.mStart).count(),
+                 event.mThread,
+                 event.mFrame);
+    mFirstTraceEvent = false;
+  }
+
+  mTraceEvents.clear();
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// ProfilerWindow
+///////////////////////////////////////////////////////////////////////////////////
+void ProfilerWindow()
+{
+  ImGui::Begin("Profiler", nullptr);
+
+#if MAT300_PROFILE
+  for (auto &stage : Profiler::Get().Stages())
+  {
+    // Once the history is full the oldest value is at mNext.
+    auto offset = (Profiler::cHistory == stage.mCount) ? static_cast<int>(stage.mNext) : 0;
+
+    ImGui::Text("%s", stage.mName);
+    ImGui::Text("  min %.3f, avg %.3f, p99 %.3f ms",
+                stage.Min(),
+                stage.Average(),
+                stage.Percentile(99.0f));
+
+    ImGui::PushID(stage.mName);
+    ImGui::PlotLines("##history",
+                     stage.mHistory,
+                     static_cast<int>(stage.mCount),
+                     offset,
+                     nullptr,
+                     0.0f,
+                     FLT_MAX,
+                     ImVec2(0, 40));
+    ImGui::PopID();
+  }
+#else
+  ImGui::Text("Built with MAT300_PROFILE = 0.");
+#endif
+
+  ImGui::End();
+}
@@ -0,0 +1,139 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Define MAT300_PROFILE as 0 to compile every PROFILE_SCOPE out.
+#ifndef MAT300_PROFILE
+  #define MAT300_PROFILE 1
+#endif
+
+// Collects how long each named stage takes per frame, and keeps a rolling
+// history of the last cHistory frames of each.
+//
+// Stages are registered once per call site (see PROFILE_SCOPE) and
+// afterwards identified by index, so timing a scope is two clock reads and
+// an add under an uncontended lock.
+//
+// Every scope can also be recorded to a Chrome trace-event JSON file (load
+// it in chrome://tracing or ui.perfetto.dev). Events are buffered for a
+// frame and written out in EndFrame, so long captures don't pile up in
+// memory.
+class Profiler
+{
+public:
+  using Clock = std::chrono::high_resolution_clock;
+
+  static constexpr size_t cHistory = 240;
+
+  struct Stage
+  {
+    const char *mName;
+
+    // Milliseconds per frame, as a ring buffer starting at mNext once full.
+    float mHistory[cHistory] = {};
+    size_t mNext{ 0 };
+    size_t mCount{ 0 };
+
+    // Time spent so far this frame, and if the stage ran at all.
+    float mCurrent{ 0.0f };
+    bool mRan{ false };
+
+    float Min() const;
+    float Average() const;
+    float Percentile(float aPercent) const;
+    float Last() const;
+  };
+
+  static Profiler& Get();
+
+  // Returns the index of the stage with this name, adding it if it's new.
+  // aName must outlive the profiler, string literals are expected.
+  size_t StageIndex(const char *aName);
+
+  void Record(size_t aStage, Clock::time_point aStart, Clock::time_point aEnd);
+
+  // Moves this frame's times into each stage's history. Stages that didn't
+  // run this frame are left alone, so their stats only cover the frames
+  // they actually ran in.
+  void EndFrame();
+
+  // Forgets every stage's history, the stages themselves stay registered.
+  void Reset();
+
+  // Copy of the stages, safe to read while other threads keep recording.
+  std::vector<Stage> Stages();
+
+  // Starts writing every recorded scope to aPath, returns false if the file
+  // couldn't be opened. Stops any trace already running.
+  bool BeginTrace(const char *aPath);
+  void EndTrace();
+  bool IsTracing();
+
+  ~Profiler();
+
+private:
+  struct TraceEvent
+  {
+    size_t mStage;
+    size_t mThread;
+    size_t mFrame;
+    Clock::time_point mStart;
+    Clock::time_point mEnd;
+  };
+
+  // Small, stable id for the calling thread, trace viewers group by it.
+  size_t ThreadIndex();
+  void WriteTraceEvents();
+
+  std::mutex mMutex;
+  std::vector<Stage> mStages;
+
+  std::vector<std::thread::id> mThreads;
+  std::vector<TraceEvent> mTraceEvents;
+  std::FILE *mTraceFile{ nullptr };
+  Clock::time_point mTraceStart;
+  size_t mFrame{ 0 };
+  bool mFirstTraceEvent{ true };
+};
+
+class ScopedTimer
+{
+public:
+  explicit ScopedTimer(size_t aStage)
+    : mStage(aStage)
+    , mStart(Profiler::Clock::now())
+  {
+  }
+
+  ~ScopedTimer()
+  {
+    Profiler::Get().Record(mStage, mStart, Profiler::Clock::now());
+  }
+
+  ScopedTimer(const ScopedTimer&) = delete;
+  ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+private:
+  size_t mStage;
+  Profiler::Clock::time_point mStart;
+};
+
+#define PROFILE_CONCATENATE_IMPL(aLeft, aRight) aLeft##aRight
+#define PROFILE_CONCATENATE(aLeft, aRight) PROFILE_CONCATENATE_IMPL(aLeft, aRight)
+
+#if MAT300_PROFILE
+  // Times the rest of the enclosing scope as the stage aName.
+  #define PROFILE_SCOPE(aName)                                                                   \
+    static const size_t PROFILE_CONCATENATE(profileStage, __LINE__) = Profiler::Get().StageIndex(aName); \
+    ScopedTimer PROFILE_CONCATENATE(profileTimer, __LINE__)(PROFILE_CONCATENATE(profileStage, __LINE__))
+#else
+  #define PROFILE_SCOPE(aName)
+#endif
+
+// ImGui panel showing the min/average/p99 and history of every stage.
+void ProfilerWindow();
@@ -1,63 +1,35 @@
+#include <algorithm>
 #include <utility>
 #include <vector>
 
+#include "CurveEvaluation.hpp"
 #include "Projects.hpp"
 
 Project::Project()
   : m3D(false)
   , mCurve(this)
-  , mXAxis(this)
-  , mYAxis(this)
-  , mZAxis(this)
+  , mLines(this)
+  , mXAxis(this, { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f })
+  , mYAxis(this, { 0.0f, 1.0f, 0.0f }, { 1.0f, 0.0f, 0.0f })
+  , mZAxis(this, { 0.0f, 0.0f, 1.0f }, { 1.0f, 0.0f, 0.0f })
   , mPosition(5.24f, 0.0f, 7.39f)
   , mControlPoints(2)
   , mPointDrawer(this)
+  , mRevision(1)
+  , mPointDrawerRevision(0)
+  , mFreePlacement(false)
+  , mAsyncEvaluation(true)
 {
   mXAxis.mColor = glm::vec4{ 1.0f, 0.0f, 0.0f, 1.0f };
-  mXAxis.AddLine({ -100.0f, 0.0f }, { 100.0f, 0.0f });
   mXAxis.mScale = { 9.0, 1.0f, 1.0f };
 
-  for (int i{ -100 }; i < 100; ++i)
-  {
-    float fI = static_cast<float>(i);
-    for (int j{ 1 }; j < 10; ++j)
-    {
-      float tick = (0.1f * j) + fI;
-      mXAxis.AddLine({ tick, -0.05f, 0.0f },
-                     { tick,  0.05f, 0.0f });
-    }
-      
-    mXAxis.AddLine({ fI, -0.1f, 0.0f },
-                   { fI,  0.1f, 0.0f });
-  }
-
   mYAxis.mColor = glm::vec4{ 0.0f, 1.0f, 0.0f, 1.0f };
-  mYAxis.AddLine({ 0.0f, -100.0f }, { 0.0f,  100.0f });
-    
-  for (int i{ 100 }; i > -100; --i)
-  {
-    float fI = static_cast<float>(i);
-
-    for (int j{ 1 }; j < 10; ++j)
-    {
-      float tick = (0.1f * j) + (fI - 1);
-      mYAxis.AddLine({ -0.05f, tick, 0.0f },
-                     {  0.05f, tick, 0.0f });
-    }
-      
-    mYAxis.AddLine({ -0.1f, fI, 0.0f },
-                    {  0.1f, fI, 0.0f });
-  }
 
   mZAxis.mColor = glm::vec4{ 0.0f, 0.0f, 1.0f, 1.0f };
-  mZAxis.AddLine({ 0.0f, 0.0f, -100.0f }, { 0.0f, 0.0f,  100.0f });
-
-  mXAxis.ToGPU();
-  mYAxis.ToGPU();
-  mZAxis.ToGPU();
 
   mCurve.mColor = { 0.0f, 1.0f, 1.0f, 1.0f };
-  mCurve.mShouldClear = true;
+
+  mLines.mColor = { 0.9f, 0.7f, 0.1f, 1.0f };
 
   mPointDrawer.mColor = { 1.0f, 0.1f, 1.0f, 1.0f };
   mPoints.resize(mControlPoints, 1.0f);
@@ -68,156 +40,573 @@ void NotImplemented()
   ImGui::Text("Not implemented yet!");
 }
 
-enum class Project1Type : int
+// Where the curve ends up on screen, for tessellating it to aPixelTolerance.
+ScreenMapping CurveScreenMapping(Project &aProject, float aPixelTolerance)
 {
-  NLI = 0,
-  BB = 1
-};
+  ScreenMapping mapping;
+  mapping.mModelViewProjection = aProject.ProjectionMatrix *
+                                 aProject.ViewMatrix *
+                                 glm::scale(glm::mat4{}, aProject.CurveScale());
+  mapping.mViewportSize = aProject.mWindowSize;
+  mapping.mPixelTolerance = aPixelTolerance;
+
+  return mapping;
+}
+
+// Submission stage, hands an evaluated curve to mCurve.
+template <typename tPoint>
+void SubmitCurve(Project &aProject, const std::vector<tPoint> &aCurvePoints)
+{
+  auto &curve = aProject.mCurve;
+
+  curve.Clear();
+
+  for (auto &point : aCurvePoints)
+  {
+    curve.AddPoint(point);
+  }
+}
 
 struct Project1Config
 {
   Project1Config()
-    : mType(Project1Type::NLI)
+    : mMethod(PolynomialMethod::NLI)
+    , mPixelTolerance(0.5f)
+    , mSamples(1000)
+    , mRequestedRevision(0)
+    , mRequestedMethod(PolynomialMethod::NLI)
+    , mRequestedSamples(0)
+    , mRequestedAsync(false)
+    , mSubmittedRevision(0)
   {
 
   }
 
-  Project1Type mType;
-  std::vector<float> mQ;
+  PolynomialMethod mMethod;
+  float mPixelTolerance;
+  int mSamples;
+
+  // What the curve was last asked to be evaluated from, see P1_IsDirty.
+  size_t mRequestedRevision;
+  PolynomialMethod mRequestedMethod;
+  ScreenMapping mRequestedMapping;
+  int mRequestedSamples;
+  bool mRequestedAsync;
+
+  // Project::mRevision of the curve being drawn, whichever way it was
+  // evaluated.
+  size_t mSubmittedRevision;
+
+  // Used when evaluating on the render thread.
+  PolynomialCurveEvaluator mEvaluator;
+  std::vector<glm::vec2> mCurvePoints;
+
+  AsyncPolynomialEvaluator mAsyncEvaluator;
 };
 
-size_t factorial(size_t n)
+// UI stage, only edits the config.
+void P1_Options(Project &aProject, Project1Config &aConfig)
 {
-  if (0 == n)
+  ImGui::RadioButton("NLI", (int*)(&aConfig.mMethod), static_cast<int>(PolynomialMethod::NLI)); ImGui::SameLine();
+  ImGui::RadioButton("BB", (int*)(&aConfig.mMethod),  static_cast<int>(PolynomialMethod::BB)); ImGui::SameLine();
+  ImGui::RadioButton("FD", (int*)(&aConfig.mMethod),  static_cast<int>(PolynomialMethod::FD));
+
+  if (PolynomialMethod::FD == aConfig.mMethod)
+  {
+    ImGui::SliderInt("Samples", &aConfig.mSamples, 2, 100000);
+
+    if (aProject.mPoints.size() > cForwardDifferenceMaxDegree + 1)
+    {
+      ImGui::TextDisabled("Past %d points FD samples with de Casteljau",
+                          static_cast<int>(cForwardDifferenceMaxDegree + 1));
+    }
+  }
+  else
   {
-    return 1;
+    ImGui::SliderFloat("Pixel Error", &aConfig.mPixelTolerance, 0.1f, 10.0f, "%.2f px");
   }
+}
+
+// The curve only needs to be rebuilt if the points, the method, the FD
+// sample count, or where it's evaluated changed. FD's samples are evenly
+// spaced in t, so only NLI and BB's tessellation depends on the camera.
+bool P1_IsDirty(Project &aProject, Project1Config &aConfig)
+{
+  auto mappingChanged = PolynomialMethod::FD != aConfig.mMethod &&
+                        aConfig.mRequestedMapping != CurveScreenMapping(aProject, aConfig.mPixelTolerance);
+
+  return aConfig.mRequestedRevision != aProject.mRevision ||
+         aConfig.mRequestedMethod != aConfig.mMethod ||
+         mappingChanged ||
+         aConfig.mRequestedSamples != aConfig.mSamples ||
+         aConfig.mRequestedAsync != aProject.mAsyncEvaluation;
+}
+
+// Snapshot stage, captures everything the evaluation needs.
+PolynomialCurveInput P1_Snapshot(Project &aProject, Project1Config &aConfig)
+{
+  PolynomialCurveInput input;
+  input.mPoints = MakeSnapshot(aProject.mPoints);
+  input.mMethod = aConfig.mMethod;
+  input.mMapping = CurveScreenMapping(aProject, aConfig.mPixelTolerance);
+  input.mSamples = static_cast<size_t>(std::max(aConfig.mSamples, 2));
+  input.mRevision = aProject.mRevision;
+
+  aConfig.mRequestedRevision = input.mRevision;
+  aConfig.mRequestedMethod = input.mMethod;
+  aConfig.mRequestedMapping = input.mMapping;
+  aConfig.mRequestedSamples = aConfig.mSamples;
+  aConfig.mRequestedAsync = aProject.mAsyncEvaluation;
+
+  return input;
+}
+
+void Project1(Project &aProject)
+{
+  auto config = aProject.mPrivate.ConstructAndGetIfNotAlready<Project1Config>();
 
-  size_t product{ n };
+  P1_Options(aProject, *config);
 
-  for (size_t i{ n - 1 }; i > 0; --i)
+  if (P1_IsDirty(aProject, *config))
   {
-    product *= i;
+    auto input = P1_Snapshot(aProject, *config);
+
+    if (aProject.mAsyncEvaluation)
+    {
+      config->mAsyncEvaluator.Submit(std::move(input));
+    }
+    else
+    {
+      PROFILE_SCOPE("Evaluate Curve");
+      config->mEvaluator.Evaluate(input, config->mCurvePoints);
+      SubmitCurve(aProject, config->mCurvePoints);
+      config->mSubmittedRevision = input.mRevision;
+    }
   }
 
-  return product;
+  // Keep drawing the last finished curve until a newer one shows up. A
+  // result can be left over from before evaluation last went synchronous,
+  // so anything older than what's already drawn is dropped.
+  if (aProject.mAsyncEvaluation && config->mAsyncEvaluator.Update())
+  {
+    auto &latest = config->mAsyncEvaluator.Latest();
+
+    if (latest.mInput.mRevision >= config->mSubmittedRevision)
+    {
+      SubmitCurve(aProject, latest.mPoints);
+      config->mSubmittedRevision = latest.mInput.mRevision;
+    }
+  }
+
+  ImGui::Text("%d curve vertices%s",
+              static_cast<int>(aProject.mCurve.mVertices.size()),
+              config->mAsyncEvaluator.Busy() ? ", evaluating" : "");
 }
 
-float BernstienPolynomial(size_t d, size_t i, float t)
+struct Project2Config
+{
+  Project2Config()
+    : mMethod(BezierMethod::Subdivided)
+    , mSamples(1000)
+    , mPixelTolerance(0.5f)
+    , mShowConstruction(false)
+    , mShellDepth(1)
+    , mRequestedRevision(0)
+    , mRequestedMethod(BezierMethod::Subdivided)
+    , mRequestedSamples(0)
+    , mRequestedShellDepth(0)
+  {
+
+  }
+
+  BezierMethod mMethod;
+  int mSamples;
+  float mPixelTolerance;
+  bool mShowConstruction;
+  int mShellDepth;
+
+  // What the curve was last evaluated from, see P2_IsDirty.
+  size_t mRequestedRevision;
+  BezierMethod mRequestedMethod;
+  int mRequestedSamples;
+  ScreenMapping mRequestedMapping;
+  size_t mRequestedShellDepth;
+
+  BezierCurveEvaluator mEvaluator;
+  std::vector<glm::vec3> mCurvePoints;
+  std::vector<glm::vec3> mShells;
+};
+
+// Shells are only handed out by subdivision.
+size_t P2_ShellDepth(Project2Config &aConfig)
 {
-  //((1-t)^(d-i)) * (t^i) * ((d!)/((d - i)! * i!))
-  return static_cast<float>(glm::pow((1 - t), (d - i)) *
-    glm::pow(t, i) *
-    ((factorial(d)) / (factorial(d - i) * factorial(i))));
+  if (BezierMethod::Subdivided != aConfig.mMethod || false == aConfig.mShowConstruction)
+  {
+    return 0;
+  }
+
+  return static_cast<size_t>(std::max(aConfig.mShellDepth, 1));
 }
 
-glm::vec2 P1_BB_GetPoint(Project &aProject, Project1Config &aConfig, size_t d, float t)
+// Lays out a fresh polygon whenever the number of control points changes,
+// evenly spaced along y = 1 like the functions' points start out.
+void P2_ResizePolygon(Project &aProject)
 {
+  auto &polygon = aProject.mFreePoints;
+  auto count = static_cast<size_t>(aProject.mControlPoints);
 
-  float product{ 0.0f };
-  for (size_t i{ 0 }; i <= d; ++i)
+  if (polygon.Size() == count)
   {
-    auto a = aProject.mPoints[i];
+    return;
+  }
+
+  polygon.mX.resize(count);
+  polygon.mY.assign(count, 1.0f);
+  polygon.mZ.clear();
 
-    product += BernstienPolynomial(d, i, t) * a;
+  auto offset = (count > 1) ? 1.0f / (count - 1) : 0.0f;
+
+  for (size_t i{ 0 }; i < count; ++i)
+  {
+    polygon.mX[i] = i * offset;
   }
 
-  return { t, product };
+  aProject.PointsChanged();
 }
 
-void P1_BB(Project &aProject)
+// UI stage, only edits the config.
+void P2_Options(Project2Config &aConfig)
 {
-  auto config = aProject.mPrivate.ConstructAndGetIfNotAlready<Project1Config>();
+  ImGui::RadioButton("Subdivided", (int*)(&aConfig.mMethod), static_cast<int>(BezierMethod::Subdivided)); ImGui::SameLine();
+  ImGui::RadioButton("Sampled", (int*)(&aConfig.mMethod), static_cast<int>(BezierMethod::Sampled));
 
-  auto &curve = aProject.mCurve;
-  auto d = aProject.mControlPoints - 1;
+  if (BezierMethod::Sampled == aConfig.mMethod)
+  {
+    ImGui::SliderInt("Samples", &aConfig.mSamples, 2, 100000);
+    return;
+  }
 
-  curve.Clear();
+  ImGui::SliderFloat("Pixel Error", &aConfig.mPixelTolerance, 0.1f, 10.0f, "%.2f px");
+  ImGui::Checkbox("Show Construction", &aConfig.mShowConstruction);
+
+  if (aConfig.mShowConstruction)
+  {
+    ImGui::SliderInt("Shell Depth", &aConfig.mShellDepth, 1, 4);
+  }
+}
+
+// Only subdivision depends on the camera.
+bool P2_IsDirty(Project &aProject, Project2Config &aConfig)
+{
+  auto mappingChanged = BezierMethod::Subdivided == aConfig.mMethod &&
+                        aConfig.mRequestedMapping != CurveScreenMapping(aProject, aConfig.mPixelTolerance);
+
+  return aConfig.mRequestedRevision != aProject.mRevision ||
+         aConfig.mRequestedMethod != aConfig.mMethod ||
+         aConfig.mRequestedSamples != aConfig.mSamples ||
+         aConfig.mRequestedShellDepth != P2_ShellDepth(aConfig) ||
+         mappingChanged;
+}
+
+// Snapshot stage, captures everything the evaluation needs.
+BezierCurveInput P2_Snapshot(Project &aProject, Project2Config &aConfig)
+{
+  BezierCurveInput input;
+  input.mPolygon = MakeSnapshot(aProject.mFreePoints);
+  input.mMethod = aConfig.mMethod;
+  input.mSamples = static_cast<size_t>(std::max(aConfig.mSamples, 2));
+  input.mMapping = CurveScreenMapping(aProject, aConfig.mPixelTolerance);
+  input.mShellDepth = P2_ShellDepth(aConfig);
+  input.mRevision = aProject.mRevision;
+
+  aConfig.mRequestedRevision = input.mRevision;
+  aConfig.mRequestedMethod = input.mMethod;
+  aConfig.mRequestedSamples = aConfig.mSamples;
+  aConfig.mRequestedMapping = input.mMapping;
+  aConfig.mRequestedShellDepth = input.mShellDepth;
+
+  return input;
+}
+
+// Hands the shells to mLines, as computed by the subdivision.
+void P2_SubmitShells(Project &aProject, const std::vector<glm::vec3> &aShells)
+{
+  auto &lines = aProject.mLines;
 
-  auto offset = 1.0f / (200 - 1);
+  lines.Clear();
 
-  for (size_t i{ 0 }; i < 200; ++i)
+  for (size_t i{ 0 }; i + 1 < aShells.size(); i += 2)
   {
-    curve.AddPoint(P1_BB_GetPoint(aProject, *config, d, i * offset));
+    lines.AddLine(aShells[i], aShells[i + 1]);
   }
+
+  lines.ToGPU();
 }
 
-glm::vec2 P1_NLI_GetPoint(Project &aProject, Project1Config &aConfig, float u)
+void Project2(Project &aProject)
 {
-  glm::vec2 toReturn{ u, 0.0f };
-  auto &Q = aConfig.mQ;
-  auto n = aProject.mControlPoints - 1;
+  auto config = aProject.mPrivate.ConstructAndGetIfNotAlready<Project2Config>();
 
-  Q = aProject.mPoints;
+  aProject.mFreePlacement = true;
+  P2_ResizePolygon(aProject);
 
-  // Referenced: 
-  // https://pages.mtu.edu/~shene/COURSES/cs3621/NOTES/spline/Bezier/de-casteljau.html
-  for (size_t k{ 1 }; k <= n; ++k)
+  P2_Options(*config);
+
+  if (P2_IsDirty(aProject, *config))
   {
-    auto nMinusK{ n - k };
+    auto input = P2_Snapshot(aProject, *config);
 
-    for (size_t i{ 0 }; i <= nMinusK; ++i)
-    {
-      Q[i] = (1.0f - u) * Q[i] + u * Q[i + 1];
-    }
+    PROFILE_SCOPE("Evaluate Curve");
+    config->mEvaluator.Evaluate(input, config->mCurvePoints, config->mShells);
+    SubmitCurve(aProject, config->mCurvePoints);
+    P2_SubmitShells(aProject, config->mShells);
   }
 
-  toReturn.y = Q[0];
-
-  return toReturn;
+  ImGui::Text("%d curve vertices", static_cast<int>(aProject.mCurve.mVertices.size()));
 }
 
-void P1_NLI(Project &aProject)
+struct Project3Config
 {
-  auto config = aProject.mPrivate.ConstructAndGetIfNotAlready<Project1Config>();
+  Project3Config()
+    : mMethod(InterpolationMethod::Newton)
+    , mChebyshev(false)
+    , mPixelTolerance(0.5f)
+    , mRequestedRevision(0)
+    , mRequestedMethod(InterpolationMethod::Newton)
+    , mNodesChebyshev(false)
+  {
 
-  auto &curve = aProject.mCurve;
+  }
 
-  curve.Clear();
+  InterpolationMethod mMethod;
+  bool mChebyshev;
+  float mPixelTolerance;
 
-  auto offset = 1.0f / (200 - 1);
+  // What the curve was last evaluated from, see P3_IsDirty.
+  size_t mRequestedRevision;
+  ScreenMapping mRequestedMapping;
+  InterpolationMethod mRequestedMethod;
 
-  for (size_t i{0}; i < 200; ++i)
+  // Where the points are interpolated, see P3_LayoutNodes.
+  std::vector<double> mNodes;
+  bool mNodesChebyshev;
+
+  // Kept in step with the control points between frames, only the one in
+  // use is.
+  NewtonInterpolator mNewton;
+  BarycentricInterpolator mBarycentric;
+
+  AdaptiveTessellator mTessellator;
+  std::vector<glm::vec2> mCurvePoints;
+};
+
+// UI stage, only edits the config.
+void P3_Options(Project3Config &aConfig)
+{
+  ImGui::RadioButton("Newton", (int*)(&aConfig.mMethod), static_cast<int>(InterpolationMethod::Newton)); ImGui::SameLine();
+  ImGui::RadioButton("Barycentric", (int*)(&aConfig.mMethod), static_cast<int>(InterpolationMethod::Barycentric));
+
+  // Bunches the points up towards the ends, which keeps high degrees from
+  // blowing up there.
+  ImGui::Checkbox("Chebyshev Nodes", &aConfig.mChebyshev);
+
+  ImGui::SliderFloat("Pixel Error", &aConfig.mPixelTolerance, 0.1f, 10.0f, "%.2f px");
+}
+
+// Works out the nodes for the current number of points, and moves the drawn
+// points onto them when Chebyshev nodes are switched on or off.
+void P3_LayoutNodes(Project &aProject, Project3Config &aConfig)
+{
+  auto count = aProject.mPoints.size();
+  auto drawnAtNodes = aProject.mPointXs.size() == count;
+
+  if (aConfig.mNodes.size() == count &&
+      aConfig.mNodesChebyshev == aConfig.mChebyshev &&
+      drawnAtNodes == aConfig.mChebyshev)
+  {
+    return;
+  }
+
+  if (aConfig.mChebyshev)
+  {
+    ChebyshevNodes(count, aConfig.mNodes);
+    aProject.mPointXs.assign(aConfig.mNodes.begin(), aConfig.mNodes.end());
+  }
+  else
   {
-    curve.AddPoint(P1_NLI_GetPoint(aProject, *config, i * offset));
+    EquallySpacedNodes(count, aConfig.mNodes);
+    aProject.mPointXs.clear();
   }
+
+  aConfig.mNodesChebyshev = aConfig.mChebyshev;
+  aProject.PointsChanged();
 }
 
-void Project1(Project &aProject)
+bool P3_IsDirty(Project &aProject, Project3Config &aConfig)
 {
-  auto config = aProject.mPrivate.ConstructAndGetIfNotAlready<Project1Config>();
+  return aConfig.mRequestedRevision != aProject.mRevision ||
+         aConfig.mRequestedMethod != aConfig.mMethod ||
+         aConfig.mRequestedMapping != CurveScreenMapping(aProject, aConfig.mPixelTolerance);
+}
+
+// Tessellates the graph of anything with a batched Evaluate, spreading the
+// samples over the shared pool.
+template <typename tFunction>
+void TessellateFunction(AdaptiveTessellator &aTessellator,
+                        const tFunction &aFunction,
+                        const ScreenMapping &aMapping,
+                        std::vector<glm::vec2> &aOut)
+{
+  aTessellator.Tessellate([&aFunction](const float *aTs, float *aYs, size_t aCount)
+  {
+    ThreadPool::Shared().ParallelFor(aCount, cParallelSampleGrain, [&](size_t aBegin, size_t aEnd)
+    {
+      aFunction.Evaluate(aTs + aBegin, aYs + aBegin, aEnd - aBegin);
+    });
+  }, aMapping, aOut);
+}
 
-  ImGui::RadioButton("NLI", (int*)(&config->mType), static_cast<int>(Project1Type::NLI)); ImGui::SameLine();
-  ImGui::RadioButton("BB", (int*)(&config->mType),  static_cast<int>(Project1Type::BB)); ImGui::SameLine();
+void Project3(Project &aProject)
+{
+  auto config = aProject.mPrivate.ConstructAndGetIfNotAlready<Project3Config>();
+
+  P3_Options(*config);
+  P3_LayoutNodes(aProject, *config);
 
-  switch (config->mType)
+  if (P3_IsDirty(aProject, *config))
   {
-    case Project1Type::NLI: 
+    config->mRequestedRevision = aProject.mRevision;
+    config->mRequestedMethod = config->mMethod;
+    config->mRequestedMapping = CurveScreenMapping(aProject, config->mPixelTolerance);
+
+    auto newton = InterpolationMethod::Newton == config->mMethod;
+
     {
-      P1_NLI(aProject);
-      break;
+      PROFILE_SCOPE("Update Interpolant");
+
+      if (newton)
+      {
+        SyncInterpolator(config->mNewton, config->mNodes, aProject.mPoints);
+      }
+      else
+      {
+        SyncInterpolator(config->mBarycentric, config->mNodes, aProject.mPoints);
+      }
     }
-    case Project1Type::BB:
+
     {
-      P1_BB(aProject);
-      break;
+      PROFILE_SCOPE("Evaluate Curve");
+
+      if (newton)
+      {
+        TessellateFunction(config->mTessellator, config->mNewton, config->mRequestedMapping, config->mCurvePoints);
+      }
+      else
+      {
+        TessellateFunction(config->mTessellator, config->mBarycentric, config->mRequestedMapping, config->mCurvePoints);
+      }
     }
+
+    SubmitCurve(aProject, config->mCurvePoints);
   }
+
+  ImGui::Text("%d curve vertices", static_cast<int>(aProject.mCurve.mVertices.size()));
 }
 
-void Project2(Project &aProject)
+struct Project4Config
 {
-  NotImplemented();
+  Project4Config()
+    : mEnd(SplineEnd::Natural)
+    , mStartSlope(0.0f)
+    , mEndSlope(0.0f)
+    , mPixelTolerance(0.5f)
+    , mRequestedRevision(0)
+    , mRequestedEnd(SplineEnd::Natural)
+    , mRequestedStartSlope(0.0f)
+    , mRequestedEndSlope(0.0f)
+  {
+
+  }
+
+  SplineEnd mEnd;
+  float mStartSlope;
+  float mEndSlope;
+  float mPixelTolerance;
+
+  // What the curve was last evaluated from, see P4_IsDirty.
+  size_t mRequestedRevision;
+  ScreenMapping mRequestedMapping;
+  SplineEnd mRequestedEnd;
+  float mRequestedStartSlope;
+  float mRequestedEndSlope;
+
+  // The knots never move, so the factored system is kept between frames.
+  std::vector<double> mKnots;
+  CubicSpline mSpline;
+
+  AdaptiveTessellator mTessellator;
+  std::vector<glm::vec2> mCurvePoints;
+};
+
+// UI stage, only edits the config.
+void P4_Options(Project4Config &aConfig)
+{
+  ImGui::RadioButton("Natural", (int*)(&aConfig.mEnd), static_cast<int>(SplineEnd::Natural)); ImGui::SameLine();
+  ImGui::RadioButton("Clamped", (int*)(&aConfig.mEnd), static_cast<int>(SplineEnd::Clamped));
+
+  if (SplineEnd::Clamped == aConfig.mEnd)
+  {
+    ImGui::SliderFloat("Start Slope", &aConfig.mStartSlope, -10.0f, 10.0f);
+    ImGui::SliderFloat("End Slope", &aConfig.mEndSlope, -10.0f, 10.0f);
+  }
+
+  ImGui::SliderFloat("Pixel Error", &aConfig.mPixelTolerance, 0.1f, 10.0f, "%.2f px");
 }
 
-void Project3(Project &aProject)
+bool P4_IsDirty(Project &aProject, Project4Config &aConfig)
 {
-  NotImplemented();
+  return aConfig.mRequestedRevision != aProject.mRevision ||
+         aConfig.mRequestedEnd != aConfig.mEnd ||
+         aConfig.mRequestedStartSlope != aConfig.mStartSlope ||
+         aConfig.mRequestedEndSlope != aConfig.mEndSlope ||
+         aConfig.mRequestedMapping != CurveScreenMapping(aProject, aConfig.mPixelTolerance);
 }
 
 void Project4(Project &aProject)
 {
-  NotImplemented();
+  auto config = aProject.mPrivate.ConstructAndGetIfNotAlready<Project4Config>();
+
+  P4_Options(*config);
+
+  if (P4_IsDirty(aProject, *config))
+  {
+    config->mRequestedRevision = aProject.mRevision;
+    config->mRequestedEnd = config->mEnd;
+    config->mRequestedStartSlope = config->mStartSlope;
+    config->mRequestedEndSlope = config->mEndSlope;
+    config->mRequestedMapping = CurveScreenMapping(aProject, config->mPixelTolerance);
+
+    {
+      PROFILE_SCOPE("Update Interpolant");
+
+      if (config->mKnots.size() != aProject.mPoints.size())
+      {
+        EquallySpacedNodes(aProject.mPoints.size(), config->mKnots);
+      }
+
+      config->mSpline.SetEndSlopes(config->mStartSlope, config->mEndSlope);
+      SyncSpline(config->mSpline, config->mKnots, config->mEnd, aProject.mPoints);
+    }
+
+    {
+      PROFILE_SCOPE("Evaluate Curve");
+      TessellateFunction(config->mTessellator, config->mSpline, config->mRequestedMapping, config->mCurvePoints);
+    }
+
+    SubmitCurve(aProject, config->mCurvePoints);
+  }
+
+  ImGui::Text("%d curve vertices", static_cast<int>(aProject.mCurve.mVertices.size()));
 }
 
 void Project5(Project &aProject)
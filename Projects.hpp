@@ -4,6 +4,8 @@
 #include "imgui_impl_glfw_gl3.h"
 
 #include "PrivateImplementation.hpp"
+#include "CurveMath.hpp"
+#include "Profiler.hpp"
 #include "Rendering.hpp"
 
 
@@ -16,28 +18,90 @@ struct Project
   static std::vector<std::pair<std::string, ProjectFunction>> aProjectFunctions;
   static std::vector<const char*> mProjectNames;
 
+  // Caches this frame's camera in ProjectionMatrix and ViewMatrix.
+  void UpdateCamera()
+  {
+    ProjectionMatrix = CameraProjection(mWindowSize);
+    ViewMatrix = CameraView(mPosition);
+  }
+
+  // The curve and points are stretched by the axis scales when drawn.
+  glm::vec3 CurveScale() const
+  {
+    return { mXAxis.mScale.x, mYAxis.mScale.y, mZAxis.mScale.z };
+  }
+
   void RenderAxis()
   {
-    mXAxis.Draw();
-    mYAxis.Draw();
+    UpdateCamera();
+    mRenderer.BeginFrame(ProjectionMatrix, ViewMatrix, mWindowSize);
 
-    if (m3D)
     {
-      //mZAxis.Draw();
+      PROFILE_SCOPE("Draw Axes");
+      mXAxis.Draw();
+      mYAxis.Draw();
+
+      if (m3D)
+      {
+        //mZAxis.Draw();
+      }
     }
 
-    mCurve.Draw();
+    {
+      PROFILE_SCOPE("Draw Lines");
+      mLines.Draw();
+    }
+
+    {
+      PROFILE_SCOPE("Draw Curve");
+      mCurve.Draw();
+    }
 
-    mPointDrawer.FromYValues(mPoints);
-    mPointDrawer.ToGPU();
-    mPointDrawer.Draw();
+    {
+      PROFILE_SCOPE("Draw Points");
+
+      if (mPointDrawerRevision != mRevision)
+      {
+        if (mFreePlacement)
+        {
+          mPointDrawer.FromPolygon(mFreePoints);
+        }
+        else
+        {
+          mPointDrawer.FromYValues(mPoints, mPointXs);
+        }
+
+        mPointDrawer.ToGPU();
+        mPointDrawerRevision = mRevision;
+      }
+
+      mPointDrawer.Draw();
+    }
+
+    PROFILE_SCOPE("Renderer Flush");
+    mRenderer.Flush();
+  }
+
+  // Must be called whenever mPoints, mFreePoints or mControlPoints are
+  // modified, anything derived from them is only rebuilt when the revision
+  // changes.
+  void PointsChanged()
+  {
+    ++mRevision;
   }
 
+  // Must be declared before the drawers, they submit to it.
+  Renderer mRenderer;
+
   CurveBuilder mCurve;
 
-  LineDrawer mXAxis;
-  LineDrawer mYAxis;
-  LineDrawer mZAxis;
+  // Anything else a project wants drawn alongside its curve, like how the
+  // curve was constructed.
+  LineDrawer mLines;
+
+  AxisDrawer mXAxis;
+  AxisDrawer mYAxis;
+  AxisDrawer mZAxis;
   PointDrawer mPointDrawer;
 
   glm::mat4 ProjectionMatrix;
@@ -49,8 +113,24 @@ struct Project
 
   std::vector<float> mPoints;
 
+  // Where along x mPoints sit, for projects that don't space them evenly,
+  // empty when they are. Cleared when the project changes.
+  std::vector<float> mPointXs;
+
+  size_t mRevision;
+  size_t mPointDrawerRevision;
+
+  // Points that can be placed anywhere, for the projects that draw curves
+  // rather than functions. Those projects set mFreePlacement every frame,
+  // then input and drawing use mFreePoints instead of mPoints.
+  BezierControlPolygon mFreePoints;
+  bool mFreePlacement;
+
   glm::ivec2 mWindowSize;
 
+  // Evaluate curves on the worker pool instead of the render thread.
+  bool mAsyncEvaluation;
+
   bool m3D;
 };
 
@@ -1,5 +1,8 @@
 #include "Projects.hpp"
 #include "Rendering.hpp"
+#include <cstddef>
+
+#include <glm/gtc/packing.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
 // Compile a shader
@@ -104,6 +107,27 @@ glm::mat4 NicksViewMatrix(glm::vec3 aRight,
 
 
 
+glm::mat4 CameraProjection(glm::ivec2 aWindowSize)
+{
+  auto width = static_cast<float>(std::max(aWindowSize.x, 1));
+  auto height = static_cast<float>(std::max(aWindowSize.y, 1));
+
+  return glm::perspective(glm::radians(45.0f),
+                          width / height,
+                          0.1f,
+                          100.0f);
+}
+
+glm::mat4 CameraView(glm::vec3 aPosition)
+{
+  return NicksViewMatrix({ 1.0f, 0.0f, 0.0f },
+                         { 0.0f, 1.0f, 0.0f },
+                         { 0.0f, 0.0f, -1.0f },
+                         aPosition);
+}
+
+
+
 glm::mat4 NicksProjMatrix(int aWidth, int aHeight)
 {
   glm::mat4 proj;
@@ -128,9 +152,13 @@ glm::mat4 NicksProjMatrix(int aWidth, int aHeight)
 const char* lineVertexShader = R"foo(
 #version 330
 
-uniform mat4 Projection, View, Model;
+layout (std140) uniform Camera
+{
+  mat4 Projection;
+  mat4 View;
+};
 
-layout (location = 0) in vec4 inPosition;
+layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec4 inColor;
 
 out vec4 outColor;
@@ -141,8 +169,7 @@ void main()
 
   gl_Position = Projection * 
                 View * 
-                Model * 
-                inPosition;
+                vec4(inPosition, 1.0f);
 }
 )foo";
 
@@ -160,258 +187,472 @@ void main()
 )foo";
 
 
+// Instance 0 is the axis line across the visible range, every other
+// instance is one tick.
+const char* axisVertexShader = R"foo(
+#version 330
+
+layout (std140) uniform Camera
+{
+  mat4 Projection;
+  mat4 View;
+};
+
+uniform vec3 Direction;
+uniform vec3 Across;
+uniform vec3 Scale;
+uniform vec4 Color;
+uniform vec2 Range;
+uniform int FirstTick;
+uniform float TickStep;
+uniform int MajorEvery;
+
+out vec4 outColor;
+
+void main()
+{
+  outColor = Color;
+
+  float side = (gl_VertexID == 0) ? -1.0f : 1.0f;
+  vec3 position;
+
+  if (gl_InstanceID == 0)
+  {
+    position = Direction * ((gl_VertexID == 0) ? Range.x : Range.y);
+  }
+  else
+  {
+    int tick = FirstTick + gl_InstanceID - 1;
+    float size = ((abs(tick) % MajorEvery) == 0) ? 0.1f : 0.05f;
+
+    position = Direction * (float(tick) * TickStep) + Across * (size * side);
+  }
+
+  gl_Position = Projection * 
+                View * 
+                vec4(position * Scale, 1.0f);
+}
+)foo";
+
+
 ///////////////////////////////////////////////////////////////////////////////////
-// LineDrawer
+// GPUBuffer
 ///////////////////////////////////////////////////////////////////////////////////
-CurveBuilder::CurveBuilder(Project *aProject)
-  : mScale{1.0f, 1.0f, 1.0f}
-  , mProject(aProject)
-  , mShouldClear(false)
+GPUBuffer::GPUBuffer()
+  : mBuffer(0)
+  , mTarget(GL_ARRAY_BUFFER)
 {
-  mShaderProgram = CreateProgram(lineVertexShader, lineFragmentShader);
+}
+
+GPUBuffer::~GPUBuffer()
+{
+  if (0 != mBuffer)
+  {
+    glDeleteBuffers(1, &mBuffer);
+  }
+}
+
+void GPUBuffer::Create(GLenum aTarget)
+{
+  mTarget = aTarget;
+  glGenBuffers(1, &mBuffer);
+}
+
+void GPUBuffer::Bind()
+{
+  glBindBuffer(mTarget, mBuffer);
+}
+
+void GPUBuffer::Upload(const void *aData, size_t aSize)
+{
+  auto data = static_cast<const unsigned char*>(aData);
+  auto update = mShadow.Update(aData, aSize);
+
+  Bind();
+
+  if (update.mReallocate)
+  {
+    glBufferData(mTarget, update.mCapacity, nullptr, GL_DYNAMIC_DRAW);
+  }
+
+  if (0 != update.mSize)
+  {
+    glBufferSubData(mTarget, update.mOffset, update.mSize, data + update.mOffset);
+  }
+}
+
+
+
+
+
+
+
+
 
-  // Get the location of the attributes that enters in the vertex shader
-  //glBindAttribLocation(mShaderProgram, 0, "inPosition");
-  //glBindAttribLocation(mShaderProgram, 1, "inColor");
 
+
+///////////////////////////////////////////////////////////////////////////////////
+// Renderer
+///////////////////////////////////////////////////////////////////////////////////
+constexpr GLuint cCameraBinding = 0;
+
+Renderer::Renderer()
+  : mLineCount(0)
+  , mPointCount(0)
+  , mStreamDirty(true)
+{
+  mShaderProgram = CreateProgram(lineVertexShader, lineFragmentShader);
   LinkProgram(mShaderProgram);
 
-  mProjectionLocation = glGetUniformLocation(mShaderProgram, "Projection");
-  mViewLocation = glGetUniformLocation(mShaderProgram, "View");
-  mModelLocation = glGetUniformLocation(mShaderProgram, "Model");
+  auto cameraIndex = glGetUniformBlockIndex(mShaderProgram, "Camera");
+  glUniformBlockBinding(mShaderProgram, cameraIndex, cCameraBinding);
+
+  mAxisProgram = CreateProgram(axisVertexShader, lineFragmentShader);
+  LinkProgram(mAxisProgram);
+
+  cameraIndex = glGetUniformBlockIndex(mAxisProgram, "Camera");
+  glUniformBlockBinding(mAxisProgram, cameraIndex, cCameraBinding);
+
+  mAxisDirectionLocation = glGetUniformLocation(mAxisProgram, "Direction");
+  mAxisAcrossLocation = glGetUniformLocation(mAxisProgram, "Across");
+  mAxisScaleLocation = glGetUniformLocation(mAxisProgram, "Scale");
+  mAxisColorLocation = glGetUniformLocation(mAxisProgram, "Color");
+  mAxisRangeLocation = glGetUniformLocation(mAxisProgram, "Range");
+  mAxisFirstTickLocation = glGetUniformLocation(mAxisProgram, "FirstTick");
+  mAxisTickStepLocation = glGetUniformLocation(mAxisProgram, "TickStep");
+  mAxisMajorEveryLocation = glGetUniformLocation(mAxisProgram, "MajorEvery");
+
+  // The axes don't have any attributes, but core profile still wants a
+  // Vertex Array Object bound to draw.
+  glGenVertexArrays(1, &mAxisVertexArrayObject);
+
+  mCameraBuffer.Create(GL_UNIFORM_BUFFER);
+  mCameraBuffer.Upload(&mCamera, sizeof(mCamera));
+  glBindBufferBase(GL_UNIFORM_BUFFER, cCameraBinding, mCameraBuffer.mBuffer);
 
   // Use a Vertex Array Object
   glGenVertexArrays(1, &mVertexArrayObject);
   glBindVertexArray(mVertexArrayObject);
 
   // Create a Vector Buffer Object that will store the vertices on video memory
-  glGenBuffers(1, &mVertexBufferObject);
-
-  // Allocate space and upload the data from CPU to GPU
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_DYNAMIC_DRAW);
+  mVertexBuffer.Create(GL_ARRAY_BUFFER);
+  mVertexBuffer.Bind();
 
   glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
+  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)(offsetof(PackedVertex, mPosition)));
 
   glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(4 * sizeof(float)));
+  glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex), (void*)(offsetof(PackedVertex, mColor)));
 
   //Clean
   glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 }
 
-void CurveBuilder::Draw()
+Renderer::~Renderer()
 {
-  glm::mat4 model{};
-
-  mScale = { mProject->mXAxis.mScale.x,
-             mProject->mYAxis.mScale.y,
-             mProject->mZAxis.mScale.z };
+  glDeleteVertexArrays(1, &mVertexArrayObject);
+  glDeleteVertexArrays(1, &mAxisVertexArrayObject);
+  glDeleteProgram(mShaderProgram);
+  glDeleteProgram(mAxisProgram);
+}
 
-  model = glm::scale(model, mScale);
+void Renderer::BeginFrame(const glm::mat4 &aProjection,
+                          const glm::mat4 &aView,
+                          glm::ivec2 aViewportSize)
+{
+  mCamera.mProjection = aProjection;
+  mCamera.mView = aView;
+  mViewportSize = aViewportSize;
 
-  auto width = static_cast<float>(mProject->mWindowSize.x);
-  auto height = static_cast<float>(mProject->mWindowSize.y);
+  // Only actually touches the buffer if the camera moved.
+  mCameraBuffer.Upload(&mCamera, sizeof(mCamera));
 
-  //auto projection = glm::ortho(0.0f, width, height, 0.0f, 0.1f, 100.0f);
+  mSubmissions.clear();
+  mAxes.clear();
+}
 
+void Renderer::SubmitAxis(const AxisSubmission &aAxis)
+{
+  mAxes.push_back(aAxis);
+}
 
-  auto projection = glm::perspective(glm::radians(45.0f),
-                                     width / height,
-                                     0.1f,
-                                     100.0f);
+void Renderer::Submit(GLenum aPrimitive,
+                      const std::vector<Vertex> &aVertices,
+                      glm::vec3 aScale,
+                      glm::vec4 aColor,
+                      bool aDirty)
+{
+  mSubmissions.push_back({ aPrimitive, &aVertices, aScale, aColor, aVertices.size() });
+  mStreamDirty = mStreamDirty || aDirty;
+}
 
-  //auto projection = NicksProjMatrix(width, height);
-  //const float projection[4][4] =
-  //{
-  //    { 2.0f / width, 0.0f,           0.0f, 0.0f },
-  //    { 0.0f,         2.0f / -height, 0.0f, 0.0f },
-  //    { 0.0f,         0.0f,          -1.0f, 0.0f },
-  //    {-1.0f,         1.0f,           0.0f, 1.0f },
-  //};
+static bool operator==(const Renderer::Submission &aLeft, const Renderer::Submission &aRight)
+{
+  return aLeft.mPrimitive == aRight.mPrimitive &&
+         aLeft.mVertices == aRight.mVertices &&
+         aLeft.mScale == aRight.mScale &&
+         aLeft.mColor == aRight.mColor &&
+         aLeft.mCount == aRight.mCount;
+}
 
-  auto view = NicksViewMatrix({ 1.0f, 0.0f, 0.0f },
-                              { 0.0f, 1.0f, 0.0f }, 
-                              { 0.0f, 0.0f, -1.0f }, 
-                              mProject->mPosition);
+void Renderer::Flush()
+{
+  if (mSubmissions != mLastSubmissions)
+  {
+    mStreamDirty = true;
+  }
 
-  //glm::mat4 view;
+  if (mStreamDirty)
+  {
+    BuildStream();
+    mVertexBuffer.Upload(mStream);
+    mStreamDirty = false;
+  }
 
-  glUseProgram(mShaderProgram);
+  std::swap(mLastSubmissions, mSubmissions);
 
-  glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
-  glUniformMatrix4fv(mViewLocation, 1, GL_FALSE, glm::value_ptr(view));
-  glUniformMatrix4fv(mModelLocation, 1, GL_FALSE, glm::value_ptr(model));
+  glLineWidth(4.5f);
+  DrawAxes();
 
+  glUseProgram(mShaderProgram);
   glBindVertexArray(mVertexArrayObject);
 
-  // Allocate space and upload the data from CPU to GPU
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_DYNAMIC_DRAW);
-
-  glLineWidth(4.5f);
-  glDrawArrays(GL_LINE_STRIP, 0, static_cast<int>(mVertices.size()));
+  // Everything lands in two draws, points go last so they're on top.
+  glDrawArrays(GL_LINES, 0, static_cast<int>(mLineCount));
 
-  if (mShouldClear)
-  {
-    Clear();
-  }
+  glPointSize(10.0f);
+  glDrawArrays(GL_POINTS, static_cast<int>(mLineCount), static_cast<int>(mPointCount));
 
   //Clean
-  //glBindBuffer(GL_ARRAY_BUFFER, 0);
   glBindVertexArray(0);
 }
 
-void CurveBuilder::AddPoint(glm::vec2 aPoint)
+// Where the camera's view of the z = 0 plane starts and ends.
+static bool VisibleRegion(const Renderer::Camera &aCamera, glm::vec2 &aMin, glm::vec2 &aMax)
 {
-  mVertices.emplace_back(aPoint, mColor);
-}
+  auto inverse = glm::inverse(aCamera.mProjection * aCamera.mView);
 
-void CurveBuilder::AddPoint(glm::vec3 aPoint)
-{
-  mVertices.emplace_back(aPoint, mColor);
+  aMin = glm::vec2{ std::numeric_limits<float>::max() };
+  aMax = glm::vec2{ -std::numeric_limits<float>::max() };
+  bool found{ false };
+
+  for (float x : { -1.0f, 1.0f })
+  {
+    for (float y : { -1.0f, 1.0f })
+    {
+      auto nearPoint = inverse * glm::vec4{ x, y, -1.0f, 1.0f };
+      auto farPoint = inverse * glm::vec4{ x, y, 1.0f, 1.0f };
+      glm::vec3 start = glm::vec3{ nearPoint } / nearPoint.w;
+      glm::vec3 end = glm::vec3{ farPoint } / farPoint.w;
+
+      // Corner rays that never reach the plane don't bound anything.
+      if ((start.z > 0.0f) == (end.z > 0.0f))
+      {
+        continue;
+      }
+
+      auto t = start.z / (start.z - end.z);
+      glm::vec2 onPlane = glm::vec2{ start + (end - start) * t };
+
+      aMin = glm::min(aMin, onPlane);
+      aMax = glm::max(aMax, onPlane);
+      found = true;
+    }
+  }
+
+  return found;
 }
 
-void CurveBuilder::Clear()
+void Renderer::DrawAxes()
 {
-  mVertices.clear();
-}
+  if (mAxes.empty())
+  {
+    return;
+  }
 
+  glm::vec2 visibleMin;
+  glm::vec2 visibleMax;
 
+  if (false == VisibleRegion(mCamera, visibleMin, visibleMax))
+  {
+    return;
+  }
 
+  glUseProgram(mAxisProgram);
+  glBindVertexArray(mAxisVertexArrayObject);
 
+  for (auto &axis : mAxes)
+  {
+    // Only the axes in the plane can be placed against the visible region.
+    glm::vec2 direction{ axis.mDirection };
+    glm::vec2 scale{ axis.mScale };
+
+    if (glm::dot(direction, direction) < 0.5f)
+    {
+      continue;
+    }
+
+    // Visible stretch of the axis, in the axis' own (unscaled) units.
+    auto index = (std::abs(direction.x) > std::abs(direction.y)) ? 0 : 1;
+    auto start = visibleMin[index] / scale[index];
+    auto end = visibleMax[index] / scale[index];
+
+    // Don't let ticks get closer than a few pixels, drop to whole units if
+    // they would.
+    constexpr float minorStep = 0.1f;
+    auto pixelsPerUnit = mViewportSize[index] / std::max(end - start, 1e-6f);
+    auto step = (minorStep * pixelsPerUnit < 4.0f) ? 1.0f : minorStep;
+    auto majorEvery = (1.0f == step) ? 1 : 10;
+
+    auto firstTick = static_cast<int>(std::ceil(start / step));
+    auto lastTick = static_cast<int>(std::floor(end / step));
+    auto ticks = std::max(lastTick - firstTick + 1, 0);
+
+    glUniform3fv(mAxisDirectionLocation, 1, glm::value_ptr(axis.mDirection));
+    glUniform3fv(mAxisAcrossLocation, 1, glm::value_ptr(axis.mAcross));
+    glUniform3fv(mAxisScaleLocation, 1, glm::value_ptr(axis.mScale));
+    glUniform4fv(mAxisColorLocation, 1, glm::value_ptr(axis.mColor));
+    glUniform2f(mAxisRangeLocation, start, end);
+    glUniform1i(mAxisFirstTickLocation, firstTick);
+    glUniform1f(mAxisTickStepLocation, step);
+    glUniform1i(mAxisMajorEveryLocation, majorEvery);
+
+    glDrawArraysInstanced(GL_LINES, 0, 2, ticks + 1);
+  }
 
+  glBindVertexArray(0);
+}
 
+void Renderer::BuildStream()
+{
+  mStream.clear();
 
+  std::uint32_t color;
 
+  auto addScaled = [this, &color](const Vertex &aVertex, glm::vec3 aScale)
+  {
+    mStream.push_back({ aVertex.mPosition * aScale, color });
+  };
 
+  // Line strips are expanded into line lists so they batch with the axes.
+  for (auto &submission : mSubmissions)
+  {
+    auto &vertices = *submission.mVertices;
+    color = glm::packUnorm4x8(submission.mColor);
+
+    if (GL_LINES == submission.mPrimitive)
+    {
+      for (auto &vertex : vertices)
+      {
+        addScaled(vertex, submission.mScale);
+      }
+    }
+    else if (GL_LINE_STRIP == submission.mPrimitive)
+    {
+      for (size_t i{ 1 }; i < vertices.size(); ++i)
+      {
+        addScaled(vertices[i - 1], submission.mScale);
+        addScaled(vertices[i], submission.mScale);
+      }
+    }
+  }
 
+  mLineCount = mStream.size();
 
-///////////////////////////////////////////////////////////////////////////////////
-// LineDrawer
-///////////////////////////////////////////////////////////////////////////////////
-LineDrawer::LineDrawer(Project *aProject)
-  : mScale{ 1.0f, 1.0f, 1.0f }
-  , mProject(aProject)
-  , mShouldClear(false)
-{
-  mShaderProgram = CreateProgram(lineVertexShader, lineFragmentShader);
+  for (auto &submission : mSubmissions)
+  {
+    color = glm::packUnorm4x8(submission.mColor);
+
+    if (GL_POINTS == submission.mPrimitive)
+    {
+      for (auto &vertex : *submission.mVertices)
+      {
+        addScaled(vertex, submission.mScale);
+      }
+    }
+  }
 
-  // Get the location of the attributes that enters in the vertex shader
-  //glBindAttribLocation(mShaderProgram, 0, "inPosition");
-  //glBindAttribLocation(mShaderProgram, 1, "inColor");
+  mPointCount = mStream.size() - mLineCount;
+}
 
-  LinkProgram(mShaderProgram);
 
-  mProjectionLocation = glGetUniformLocation(mShaderProgram, "Projection");
-  mViewLocation = glGetUniformLocation(mShaderProgram, "View");
-  mModelLocation = glGetUniformLocation(mShaderProgram, "Model");
 
-  // Use a Vertex Array Object
-  glGenVertexArrays(1, &mVertexArrayObject);
-  glBindVertexArray(mVertexArrayObject);
 
-  // Create a Vector Buffer Object that will store the vertices on video memory
-  glGenBuffers(1, &mVertexBufferObject);
 
-  // Allocate space and upload the data from CPU to GPU
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_DYNAMIC_DRAW);
 
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
 
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(4 * sizeof(float)));
 
-  //Clean
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
-}
 
 
-void LineDrawer::ToGPU()
-{
-  glBindVertexArray(mVertexArrayObject);
 
-  // Allocate space and upload the data from CPU to GPU
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_DYNAMIC_DRAW);
+///////////////////////////////////////////////////////////////////////////////////
+// AxisDrawer
+///////////////////////////////////////////////////////////////////////////////////
+AxisDrawer::AxisDrawer(Project *aProject, glm::vec3 aDirection, glm::vec3 aAcross)
+  : mDirection(aDirection)
+  , mAcross(aAcross)
+  , mColor{ 1.0f, 1.0f, 1.0f, 1.0f }
+  , mScale{ 1.0f, 1.0f, 1.0f }
+  , mProject(aProject)
+{
 }
 
-void LineDrawer::Draw()
+void AxisDrawer::Draw()
 {
-  glm::mat4 model{};
-  model = glm::scale(model, mScale);
+  mProject->mRenderer.SubmitAxis({ mDirection, mAcross, mScale, mColor });
+}
 
-  auto width = static_cast<float>(mProject->mWindowSize.x);
-  auto height = static_cast<float>(mProject->mWindowSize.y);
 
-  //auto projection = glm::ortho(0.0f, width, height, 0.0f, 0.1f, 100.0f);
 
 
-  auto projection = glm::perspective(glm::radians(45.0f),
-    width / height,
-    0.1f,
-    100.0f);
 
-  //auto projection = NicksProjMatrix(width, height);
-  //const float projection[4][4] =
-  //{
-  //    { 2.0f / width, 0.0f,           0.0f, 0.0f },
-  //    { 0.0f,         2.0f / -height, 0.0f, 0.0f },
-  //    { 0.0f,         0.0f,          -1.0f, 0.0f },
-  //    {-1.0f,         1.0f,           0.0f, 1.0f },
-  //};
 
-  auto view = NicksViewMatrix({ 1.0f, 0.0f, 0.0f },
-    { 0.0f, 1.0f, 0.0f },
-    { 0.0f, 0.0f, -1.0f },
-    mProject->mPosition);
 
-  //glm::mat4 view;
 
-  glUseProgram(mShaderProgram);
 
-  glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
-  glUniformMatrix4fv(mViewLocation, 1, GL_FALSE, glm::value_ptr(view));
-  glUniformMatrix4fv(mModelLocation, 1, GL_FALSE, glm::value_ptr(model));
 
-  glBindVertexArray(mVertexArrayObject);
 
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
+///////////////////////////////////////////////////////////////////////////////////
+// CurveBuilder
+///////////////////////////////////////////////////////////////////////////////////
+CurveBuilder::CurveBuilder(Project *aProject)
+  : mScale{1.0f, 1.0f, 1.0f}
+  , mProject(aProject)
+  , mShouldClear(false)
+  , mDirty(false)
+{
+}
+
+void CurveBuilder::Draw()
+{
+  mScale = mProject->CurveScale();
 
-  glLineWidth(4.5f);
-  //glDrawArrays(GL_LINES, 0, static_cast<int>(mVertices.size() / 2));
-  glDrawArrays(GL_LINES, 0, static_cast<int>(mVertices.size()));
+  mProject->mRenderer.Submit(GL_LINE_STRIP, mVertices, mScale, mColor, mDirty);
+  mDirty = false;
 
   if (mShouldClear)
   {
     Clear();
   }
-
-  //Clean
-  //glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
 }
 
-void LineDrawer::AddLine(glm::vec3 aPoint1, glm::vec3 aPoint2)
+void CurveBuilder::AddPoint(glm::vec2 aPoint)
 {
-  mVertices.emplace_back(aPoint1, mColor);
-  mVertices.emplace_back(aPoint2, mColor);
+  mVertices.emplace_back(aPoint);
+  mDirty = true;
 }
 
-void LineDrawer::AddLine(glm::vec2 aPoint1, glm::vec2 aPoint2)
+void CurveBuilder::AddPoint(glm::vec3 aPoint)
 {
-  mVertices.emplace_back(aPoint1, mColor);
-  mVertices.emplace_back(aPoint2, mColor);
+  mVertices.emplace_back(aPoint);
+  mDirty = true;
 }
 
-void LineDrawer::Clear()
+void CurveBuilder::Clear()
 {
   mVertices.clear();
+  mDirty = true;
 }
 
 
@@ -424,182 +665,123 @@ void LineDrawer::Clear()
 
 
 
-
 ///////////////////////////////////////////////////////////////////////////////////
-// PointDrawer
+// LineDrawer
 ///////////////////////////////////////////////////////////////////////////////////
+LineDrawer::LineDrawer(Project *aProject)
+  : mScale{ 1.0f, 1.0f, 1.0f }
+  , mProject(aProject)
+  , mShouldClear(false)
+  , mDirty(false)
+{
+}
 
 
-const char* pointVertexShader = R"foo(
-#version 330
-
-uniform mat4 Projection, View, Model;
-
-layout (location = 0) in vec4 inPosition;
-layout (location = 1) in vec4 inColor;
-
-out vec4 outColor;
+void LineDrawer::ToGPU()
+{
+  mDirty = true;
+}
 
-void main()
+void LineDrawer::Draw()
 {
-  outColor = inColor;
+  mScale = mProject->CurveScale();
 
-  //gl_PointSize = 15.0f;
+  mProject->mRenderer.Submit(GL_LINES, mVertices, mScale, mColor, mDirty);
+  mDirty = false;
 
-  gl_Position = Projection * 
-                View * 
-                Model * 
-                inPosition;
+  if (mShouldClear)
+  {
+    Clear();
+  }
 }
-)foo";
 
-const char* pointFragmentShader = R"foo(
-#version 330
+void LineDrawer::AddLine(glm::vec3 aPoint1, glm::vec3 aPoint2)
+{
+  mVertices.emplace_back(aPoint1);
+  mVertices.emplace_back(aPoint2);
+}
 
-in vec4 outColor;
-out vec4 out_color;
+void LineDrawer::AddLine(glm::vec2 aPoint1, glm::vec2 aPoint2)
+{
+  mVertices.emplace_back(aPoint1);
+  mVertices.emplace_back(aPoint2);
+}
 
-void main()
+void LineDrawer::Clear()
 {
-  out_color = outColor;
+  mVertices.clear();
+  mDirty = true;
 }
-)foo";
 
 
 
-PointDrawer::PointDrawer(Project *aProject)
-  : mScale{ 1.0f, 1.0f, 1.0f }
-  , mProject(aProject)
-  , mShouldClear(false)
-{
-  //glEnable(GL_PROGRAM_POINT_SIZE);
-  mShaderProgram = CreateProgram(pointVertexShader, pointFragmentShader);
 
-  // Get the location of the attributes that enters in the vertex shader
-  //glBindAttribLocation(mShaderProgram, 0, "inPosition");
-  //glBindAttribLocation(mShaderProgram, 1, "inColor");
 
-  LinkProgram(mShaderProgram);
 
-  mProjectionLocation = glGetUniformLocation(mShaderProgram, "Projection");
-  mViewLocation = glGetUniformLocation(mShaderProgram, "View");
-  mModelLocation = glGetUniformLocation(mShaderProgram, "Model");
 
-  // Use a Vertex Array Object
-  glGenVertexArrays(1, &mVertexArrayObject);
-  glBindVertexArray(mVertexArrayObject);
 
-  // Create a Vector Buffer Object that will store the vertices on video memory
-  glGenBuffers(1, &mVertexBufferObject);
 
-  // Allocate space and upload the data from CPU to GPU
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_DYNAMIC_DRAW);
 
-  glEnableVertexAttribArray(0);
-  glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(0));
 
-  glEnableVertexAttribArray(1);
-  glVertexAttribPointer(1, 4, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(4 * sizeof(float)));
 
-  //Clean
-  glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
+///////////////////////////////////////////////////////////////////////////////////
+// PointDrawer
+///////////////////////////////////////////////////////////////////////////////////
+PointDrawer::PointDrawer(Project *aProject)
+  : mScale{ 1.0f, 1.0f, 1.0f }
+  , mProject(aProject)
+  , mShouldClear(false)
+  , mDirty(false)
+{
 }
 
 
 void PointDrawer::ToGPU()
 {
-  glBindVertexArray(mVertexArrayObject);
-
-  // Allocate space and upload the data from CPU to GPU
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-  glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * mVertices.size(), mVertices.data(), GL_DYNAMIC_DRAW);
+  mDirty = true;
 }
 
 void PointDrawer::Draw()
 {
-  mScale = { mProject->mXAxis.mScale.x,
-             mProject->mYAxis.mScale.y,
-             mProject->mZAxis.mScale.z };
-
-  glm::mat4 model{};
-  model = glm::scale(model, mScale);
-
-  auto width = static_cast<float>(mProject->mWindowSize.x);
-  auto height = static_cast<float>(mProject->mWindowSize.y);
-
-  //auto projection = glm::ortho(0.0f, width, height, 0.0f, 0.1f, 100.0f);
-
+  mScale = mProject->CurveScale();
 
-  auto projection = glm::perspective(glm::radians(45.0f),
-                                     width / height,
-                                     0.1f,
-                                     100.0f);
-
-  //auto projection = NicksProjMatrix(width, height);
-  //const float projection[4][4] =
-  //{
-  //    { 2.0f / width, 0.0f,           0.0f, 0.0f },
-  //    { 0.0f,         2.0f / -height, 0.0f, 0.0f },
-  //    { 0.0f,         0.0f,          -1.0f, 0.0f },
-  //    {-1.0f,         1.0f,           0.0f, 1.0f },
-  //};
-
-  auto view = NicksViewMatrix({ 1.0f, 0.0f, 0.0f },
-    { 0.0f, 1.0f, 0.0f },
-    { 0.0f, 0.0f, -1.0f },
-    mProject->mPosition);
-
-  //glm::mat4 view;
-
-  glUseProgram(mShaderProgram);
-
-  glUniformMatrix4fv(mProjectionLocation, 1, GL_FALSE, glm::value_ptr(projection));
-  glUniformMatrix4fv(mViewLocation, 1, GL_FALSE, glm::value_ptr(view));
-  glUniformMatrix4fv(mModelLocation, 1, GL_FALSE, glm::value_ptr(model));
-
-  glBindVertexArray(mVertexArrayObject);
-
-  glBindBuffer(GL_ARRAY_BUFFER, mVertexBufferObject);
-  
-  glPointSize(10.0f);
-  glDrawArrays(GL_POINTS, 0, static_cast<int>(mVertices.size()));
+  mProject->mRenderer.Submit(GL_POINTS, mVertices, mScale, mColor, mDirty);
+  mDirty = false;
 
   if (mShouldClear)
   {
     Clear();
   }
-
-  //Clean
-  //glBindBuffer(GL_ARRAY_BUFFER, 0);
-  glBindVertexArray(0);
 }
 
 void PointDrawer::AddPoint(glm::vec3 aPoint)
 {
-  mVertices.emplace_back(aPoint, mColor);
+  mVertices.emplace_back(aPoint);
 }
 
 void PointDrawer::AddPoint(glm::vec2 aPoint)
 {
-  mVertices.emplace_back(aPoint, mColor);
+  mVertices.emplace_back(aPoint);
 }
 
 void PointDrawer::Clear()
 {
   mVertices.clear();
+  mDirty = true;
 }
 
 
-void PointDrawer::FromYValues(std::vector<float> &aPoints)
+void PointDrawer::FromYValues(std::vector<float> &aPoints, const std::vector<float> &aXs)
 {
-  mVertices.clear();
+  LayoutFunctionPoints(aPoints, aXs, mVertices);
+}
 
-  auto offset = 1.0f / (aPoints.size() - 1);
+void PointDrawer::FromPolygon(const BezierControlPolygon &aPolygon)
+{
+  mVertices.clear();
 
-  for (size_t i{ 0 }; i < aPoints.size(); ++i)
+  for (size_t i{ 0 }; i < aPolygon.Size(); ++i)
   {
-    AddPoint({ i * offset, aPoints[i], 0.0f });
+    AddPoint(aPolygon.Point(i));
   }
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <cstdint>
 
 #include <algorithm>
 #include <chrono>
@@ -18,32 +19,175 @@
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtx/quaternion.hpp"
 
+#include "CurveMath.hpp"
+#include "ShadowBuffer.hpp"
+
 
 GLuint LoadAndCompileShader(const char *aSource, GLenum shaderType);
 GLuint CreateProgram(const char *aVertShaderSource, const char *aFragShaderSource);
 
 struct Project;
 
+// A GL buffer whose storage persists between uploads. ShadowBuffer keeps the
+// CPU copy and decides when storage is reallocated and which range of an
+// upload is sent through glBufferSubData.
+struct GPUBuffer
+{
+  GPUBuffer();
+  ~GPUBuffer();
+
+  GPUBuffer(const GPUBuffer&) = delete;
+  GPUBuffer& operator=(const GPUBuffer&) = delete;
+
+  void Create(GLenum aTarget);
+  void Bind();
+
+  // Replaces the contents of the buffer with aSize bytes from aData.
+  void Upload(const void *aData, size_t aSize);
+
+  template <typename tType>
+  void Upload(const std::vector<tType> &aData)
+  {
+    Upload(aData.data(), sizeof(tType) * aData.size());
+  }
+
+  GLuint mBuffer;
+  GLenum mTarget;
+  ShadowBuffer mShadow;
+};
+
+// Every vertex of a drawer shares the drawer's mColor, so only the position
+// is stored per vertex.
 struct Vertex
 {
-  Vertex(glm::vec2 aPosition, glm::vec4 aColor)
-    : mPosition(aPosition, 0.0f, 1.0f)
-    , mColor(aColor)
+  Vertex(glm::vec2 aPosition)
+    : mPosition(aPosition, 0.0f)
   {
 
   }
 
-  Vertex(glm::vec3 aPosition, glm::vec4 aColor)
-    : mPosition(aPosition, 1.0f)
-    , mColor(aColor)
+  Vertex(glm::vec3 aPosition)
+    : mPosition(aPosition)
   {
 
   }
 
-  glm::vec4 mPosition;
-  glm::vec4 mColor;
+  glm::vec3 mPosition;
 };
 
+// What the renderer actually sends to the GPU, the color is packed as RGBA8
+// to keep this at 16 bytes.
+struct PackedVertex
+{
+  glm::vec3 mPosition;
+  std::uint32_t mColor;
+};
+
+
+// Owns the one shader program every drawer uses. The camera matrices live in
+// a uniform buffer written once per frame, and the drawers submit their
+// vertices here instead of drawing themselves. Everything submitted is
+// merged into a single vertex buffer, rebuilt only when a drawer changed,
+// and drawn with one call for lines and one for points.
+struct Renderer
+{
+  struct Submission
+  {
+    GLenum mPrimitive;
+    const std::vector<Vertex> *mVertices;
+    glm::vec3 mScale;
+    glm::vec4 mColor;
+    size_t mCount;
+  };
+
+  struct Camera
+  {
+    glm::mat4 mProjection;
+    glm::mat4 mView;
+  };
+
+  struct AxisSubmission
+  {
+    glm::vec3 mDirection;
+    glm::vec3 mAcross;
+    glm::vec3 mScale;
+    glm::vec4 mColor;
+  };
+
+  // Needs a current GL context for both.
+  Renderer();
+  ~Renderer();
+
+  Renderer(const Renderer&) = delete;
+  Renderer& operator=(const Renderer&) = delete;
+
+  void BeginFrame(const glm::mat4 &aProjection,
+                  const glm::mat4 &aView,
+                  glm::ivec2 aViewportSize);
+
+  // Axes aren't stored as vertices, see AxisDrawer.
+  void SubmitAxis(const AxisSubmission &aAxis);
+
+  // aVertices must stay alive until Flush. aScale is applied to every
+  // vertex, aDirty should be set if aVertices changed since the last frame.
+  void Submit(GLenum aPrimitive,
+              const std::vector<Vertex> &aVertices,
+              glm::vec3 aScale,
+              glm::vec4 aColor,
+              bool aDirty);
+
+  void Flush();
+
+  GLuint mShaderProgram;
+  GLuint mVertexArrayObject;
+
+  GLuint mAxisProgram;
+  GLuint mAxisVertexArrayObject;
+  GLint mAxisDirectionLocation;
+  GLint mAxisAcrossLocation;
+  GLint mAxisScaleLocation;
+  GLint mAxisColorLocation;
+  GLint mAxisRangeLocation;
+  GLint mAxisFirstTickLocation;
+  GLint mAxisTickStepLocation;
+  GLint mAxisMajorEveryLocation;
+
+  GPUBuffer mVertexBuffer;
+  GPUBuffer mCameraBuffer;
+  Camera mCamera;
+  glm::ivec2 mViewportSize;
+
+  std::vector<AxisSubmission> mAxes;
+
+  std::vector<Submission> mSubmissions;
+  std::vector<Submission> mLastSubmissions;
+  std::vector<PackedVertex> mStream;
+  size_t mLineCount;
+  size_t mPointCount;
+  bool mStreamDirty;
+
+private:
+  void BuildStream();
+  void DrawAxes();
+};
+
+// An axis through the origin along mDirection, with minor ticks every 0.1
+// units and major ticks on whole units, sticking out along mAcross.
+//
+// Nothing is stored per tick: the renderer works out which stretch of the
+// axis is on screen and the shader places that many instanced ticks, so
+// the cost follows what's visible and the axis never runs out.
+struct AxisDrawer
+{
+  AxisDrawer(Project *aProject, glm::vec3 aDirection, glm::vec3 aAcross);
+  void Draw();
+
+  glm::vec3 mDirection;
+  glm::vec3 mAcross;
+  glm::vec4 mColor;
+  glm::vec3 mScale;
+  Project *mProject;
+};
 
 struct LineDrawer
 {
@@ -56,16 +200,11 @@ struct LineDrawer
   void Clear();
 
   std::vector<Vertex> mVertices;
-  GLuint mVertexArrayObject;
-  GLuint mVertexBufferObject;
-  GLuint mShaderProgram;
-  GLuint mProjectionLocation;
-  GLuint mViewLocation;
-  GLuint mModelLocation;
   glm::vec4 mColor;
   glm::vec3 mScale;
   Project *mProject;
   bool mShouldClear;
+  bool mDirty;
 };
 
 struct PointDrawer
@@ -75,22 +214,19 @@ struct PointDrawer
   void AddPoint(glm::vec3 aPoint);
   void AddPoint(glm::vec2 aPoint);
 
-  void FromYValues(std::vector<float> &aPoints);
+  // At aXs if given, otherwise evenly spaced over [0, 1].
+  void FromYValues(std::vector<float> &aPoints, const std::vector<float> &aXs = {});
+  void FromPolygon(const BezierControlPolygon &aPolygon);
   void ToGPU();
   void Clear();
 
   std::vector<Vertex> mVertices;
-  GLuint mVertexArrayObject;
-  GLuint mVertexBufferObject;
-  GLuint mShaderProgram;
-  GLuint mProjectionLocation;
-  GLuint mViewLocation;
-  GLuint mModelLocation;
   glm::vec4 mStartColor;
   glm::vec4 mColor;
   glm::vec3 mScale;
   Project *mProject;
   bool mShouldClear;
+  bool mDirty;
 };
 
 struct CurveBuilder
@@ -102,19 +238,21 @@ struct CurveBuilder
   void Clear();
 
   std::vector<Vertex> mVertices;
-  GLuint mVertexArrayObject;
-  GLuint mVertexBufferObject;
-  GLuint mShaderProgram;
-  GLuint mProjectionLocation;
-  GLuint mViewLocation;
-  GLuint mModelLocation;
   glm::vec4 mColor;
   glm::vec3 mScale;
   Project *mProject;
   bool mShouldClear;
+
+  // Set whenever mVertices changes, the renderer only rebuilds its vertex
+  // stream if some drawer is dirty.
+  bool mDirty;
 };
 
 glm::mat4 NicksViewMatrix(glm::vec3 aRight,
                           glm::vec3 aUp,
                           glm::vec3 aForward,
                           glm::vec3 aPosition);
+
+// The camera every drawer uses, looking down -z from aPosition.
+glm::mat4 CameraProjection(glm::ivec2 aWindowSize);
+glm::mat4 CameraView(glm::vec3 aPosition);
@@ -0,0 +1,57 @@
+#include <algorithm>
+
+#include "ShadowBuffer.hpp"
+
+ShadowBuffer::ShadowBuffer()
+  : mCapacity(0)
+  , mAllocations(0)
+  , mBytesUploaded(0)
+{
+}
+
+BufferUpdate ShadowBuffer::Update(const void *aData, size_t aSize)
+{
+  auto data = static_cast<const unsigned char*>(aData);
+  BufferUpdate update{ false, mCapacity, 0, 0 };
+
+  if (aSize > mCapacity)
+  {
+    // Grow geometrically so a curve that gains a few vertices a frame
+    // doesn't reallocate every frame.
+    mCapacity = std::max(aSize, mCapacity * 2);
+
+    update.mReallocate = true;
+    update.mCapacity = mCapacity;
+    update.mSize = aSize;
+    ++mAllocations;
+  }
+  else
+  {
+    // Find the range that differs from what's already on the GPU.
+    size_t common = std::min(aSize, mContents.size());
+    size_t first{ 0 };
+
+    while (first < common && mContents[first] == data[first])
+    {
+      ++first;
+    }
+
+    size_t last{ aSize };
+
+    if (aSize == mContents.size())
+    {
+      while (last > first && mContents[last - 1] == data[last - 1])
+      {
+        --last;
+      }
+    }
+
+    update.mOffset = first;
+    update.mSize = last - first;
+  }
+
+  mBytesUploaded += update.mSize;
+  mContents.assign(data, data + aSize);
+
+  return update;
+}
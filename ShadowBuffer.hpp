@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// What has to happen to a GPU buffer for it to hold new contents.
+struct BufferUpdate
+{
+  // Storage has to be reallocated to mCapacity bytes first.
+  bool mReallocate;
+  size_t mCapacity;
+
+  // The bytes [mOffset, mOffset + mSize) of the new contents have to be
+  // uploaded, mSize is 0 if nothing changed.
+  size_t mOffset;
+  size_t mSize;
+};
+
+// The CPU copy of a GPU buffer, GPUBuffer issues the GL calls and this
+// works out which ones. Storage grows geometrically so it's rarely
+// reallocated, and new contents are compared against the copy so only the
+// range that actually changed is uploaded.
+//
+// Nothing here touches GL, so the bookkeeping is tested without a context.
+class ShadowBuffer
+{
+public:
+  ShadowBuffer();
+
+  // Replaces the contents with aSize bytes from aData.
+  BufferUpdate Update(const void *aData, size_t aSize);
+
+  size_t Capacity() const { return mCapacity; }
+  const std::vector<unsigned char>& Contents() const { return mContents; }
+
+  // How often we actually hit the driver, printed by the headless
+  // benchmarks.
+  size_t Allocations() const { return mAllocations; }
+  size_t BytesUploaded() const { return mBytesUploaded; }
+
+private:
+  std::vector<unsigned char> mContents;
+  size_t mCapacity;
+  size_t mAllocations;
+  size_t mBytesUploaded;
+};
@@ -0,0 +1,1281 @@
+// Unit tests for the curve math, registered with CTest.
+//
+// Only needs the CurveMath library, so it builds anywhere that does. Each
+// test is a plain function, CHECK records a failure and carries on so one
+// run reports everything that's wrong:
+//   ctest --test-dir build --output-on-failure
+
+#include <cmath>
+#include <cstdio>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+
+#include "CurveEvaluation.hpp"
+#include "CurveMath.hpp"
+#include "ShadowBuffer.hpp"
+#include "ThreadPool.hpp"
+#include "TripleBuffer.hpp"
+
+static int gFailures{ 0 };
+
+#define CHECK(aCondition)                                                  \
+  do                                                                       \
+  {                                                                        \
+    if (false == (aCondition))                                             \
+    {                                                                      \
+      std::printf("  %s:%d: CHECK(%s) failed\n",                           \
+                  __FILE__, __LINE__, #aCondition);                        \
+      ++gFailures;                                                         \
+    }                                                                      \
+  } while (false)
+
+#define CHECK_NEAR(aValue, aExpected, aTolerance)                          \
+  do                                                                       \
+  {                                                                        \
+    double checkValue = (aValue);                                          \
+    double checkExpected = (aExpected);                                    \
+    if (false == (std::fabs(checkValue - checkExpected) <= (aTolerance)))  \
+    {                                                                      \
+      std::printf("  %s:%d: %s = %.9g, expected %.9g within %g\n",         \
+                  __FILE__, __LINE__, #aValue, checkValue, checkExpected,  \
+                  static_cast<double>(aTolerance));                        \
+      ++gFailures;                                                         \
+    }                                                                      \
+  } while (false)
+
+static std::vector<float> RandomValues(size_t aCount, float aRange = 3.0f, unsigned aSeed = 300)
+{
+  std::mt19937 generator{ aSeed };
+  std::uniform_real_distribution<float> distribution{ -aRange, aRange };
+
+  std::vector<float> values(aCount);
+
+  for (auto &value : values)
+  {
+    value = distribution(generator);
+  }
+
+  return values;
+}
+
+// Roughly Project 1's camera: [0, 1] across most of a 1280x720 window, y
+// squashed a little.
+static ScreenMapping TestMapping(float aPixelTolerance = 0.5f)
+{
+  ScreenMapping mapping{ glm::mat4{ 1.0f }, { 1280.0f, 720.0f }, aPixelTolerance };
+  mapping.mModelViewProjection[0][0] = 1.8f;
+  mapping.mModelViewProjection[3][0] = -0.9f;
+  mapping.mModelViewProjection[1][1] = 0.3f;
+
+  return mapping;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Polynomial functions
+///////////////////////////////////////////////////////////////////////////////////
+static void TestBernsteinMatchesDeCasteljau()
+{
+  std::vector<float> scratch;
+  std::vector<float> ts;
+  UniformSamples(101, ts);
+
+  for (size_t count : { 1, 2, 3, 4, 11, 50, 200 })
+  {
+    auto points = RandomValues(count);
+    std::vector<float> ys(ts.size());
+
+    EvaluateDeCasteljau(points.data(), count, ts.data(), ys.data(), ts.size(), scratch);
+
+    BernsteinBasis basis;
+    basis.SetDegree(count - 1);
+
+    for (size_t i{ 0 }; i < ts.size(); ++i)
+    {
+      CHECK_NEAR(basis.Evaluate(points.data(), ts[i]), ys[i], 1e-4);
+    }
+
+    // The ends of a Bernstein polynomial are its end coefficients.
+    CHECK_NEAR(ys.front(), points.front(), 1e-6);
+    CHECK_NEAR(ys.back(), points.back(), 1e-5);
+  }
+}
+
+// Every kernel this CPU runs against the scalar one, including sample counts
+// that leave the last block part full.
+static void TestSimdKernelsMatchScalar()
+{
+  std::vector<float> scratch;
+  auto supported = DetectSimdLevel();
+
+  for (size_t degree : { 1, 2, 3, 10, 100, 1000 })
+  {
+    auto points = RandomValues(degree + 1);
+
+    for (size_t samples : { 1, 31, 32, 33, 100, 257 })
+    {
+      auto ts = RandomValues(samples, 0.5f, 301);
+
+      for (auto &t : ts)
+      {
+        t += 0.5f;
+      }
+
+      std::vector<float> expected(samples);
+      EvaluateDeCasteljau(points.data(), points.size(), ts.data(), expected.data(), samples, scratch, SimdLevel::Scalar);
+
+      for (auto level : { SimdLevel::SSE2, SimdLevel::AVX2, SimdLevel::AVX512 })
+      {
+        if (static_cast<int>(level) > static_cast<int>(supported))
+        {
+          continue;
+        }
+
+        std::vector<float> ys(samples);
+        EvaluateDeCasteljau(points.data(), points.size(), ts.data(), ys.data(), samples, scratch, level);
+
+        // FMA rounds differently, see DeCasteljauAVX512. Building with FMA
+        // for everything lets the compiler fuse the other kernels too.
+#if defined(__FMA__)
+        auto fused = true;
+#else
+        auto fused = SimdLevel::AVX512 == level;
+#endif
+        auto tolerance = fused ? 3e-7 * (degree + 1) : 0.0;
+
+        for (size_t i{ 0 }; i < samples; ++i)
+        {
+          CHECK_NEAR(ys[i], expected[i], tolerance);
+        }
+      }
+    }
+  }
+}
+
+// BernstienPolynomial on its own has to agree with the basis table, from
+// several threads at once.
+static void TestBernstienPolynomialMatchesBasis()
+{
+  ThreadPool pool{ 3 };
+
+  for (size_t degree : { 0, 1, 5, 100, 1000 })
+  {
+    BernsteinBasis basis;
+    basis.SetDegree(degree);
+
+    for (double t : { 0.0, 0.1, 0.5, 0.77, 1.0 })
+    {
+      std::vector<double> values(degree + 1);
+      basis.Evaluate(t, values.data());
+
+      std::vector<float> singles(degree + 1);
+
+      pool.ParallelFor(degree + 1, 1, [&](size_t aBegin, size_t aEnd)
+      {
+        for (auto i{ aBegin }; i < aEnd; ++i)
+        {
+          singles[i] = BernstienPolynomial(degree, i, static_cast<float>(t));
+        }
+      });
+
+      for (size_t i{ 0 }; i <= degree; ++i)
+      {
+        CHECK_NEAR(singles[i], values[i], 1e-6);
+      }
+    }
+  }
+}
+
+static void TestBernsteinBasisSumsToOne()
+{
+  BernsteinBasis basis;
+
+  for (size_t degree : { 1, 5, 100, 1000 })
+  {
+    basis.SetDegree(degree);
+    std::vector<double> values(degree + 1);
+
+    for (double t : { 0.0, 0.1, 0.5, 0.77, 1.0 })
+    {
+      basis.Evaluate(t, values.data());
+
+      double sum{ 0.0 };
+
+      for (auto value : values)
+      {
+        sum += value;
+      }
+
+      CHECK_NEAR(sum, 1.0, 1e-9);
+    }
+  }
+}
+
+static void TestForwardDifferencesMatchDeCasteljau()
+{
+  std::vector<float> scratch;
+  std::vector<double> differenceScratch;
+
+  for (size_t count : { 2, 4, 8, 20, 100 })
+  {
+    auto points = RandomValues(count);
+
+    std::vector<float> ts;
+    UniformSamples(1000, ts);
+
+    std::vector<float> expected(ts.size());
+    std::vector<float> ys(ts.size());
+
+    EvaluateDeCasteljau(points.data(), count, ts.data(), expected.data(), ts.size(), scratch);
+    EvaluateForwardDifferences(points.data(), count, 0, ts.size(), ts.size(), ys.data(), 0, differenceScratch);
+
+    for (size_t i{ 0 }; i < ts.size(); ++i)
+    {
+      CHECK_NEAR(ys[i], expected[i], 1e-4);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Adaptive tessellation
+///////////////////////////////////////////////////////////////////////////////////
+static glm::vec2 ToPixels(const ScreenMapping &aMapping, glm::vec2 aPoint)
+{
+  auto clip = aMapping.mModelViewProjection * glm::vec4{ aPoint, 0.0f, 1.0f };
+  glm::vec2 ndc{ clip.x / clip.w, clip.y / clip.w };
+
+  return (ndc * 0.5f + 0.5f) * aMapping.mViewportSize;
+}
+
+static float DistanceToSegment(glm::vec2 aPoint, glm::vec2 aStart, glm::vec2 aEnd)
+{
+  auto segment = aEnd - aStart;
+  auto lengthSquared = glm::dot(segment, segment);
+  auto t = (lengthSquared > 0.0f) ? glm::clamp(glm::dot(aPoint - aStart, segment) / lengthSquared, 0.0f, 1.0f) : 0.0f;
+
+  return glm::length(aPoint - (aStart + t * segment));
+}
+
+static CurveSampler PolynomialSampler(const std::vector<float> &aPoints)
+{
+  return [&aPoints](const float *aTs, float *aYs, size_t aCount)
+  {
+    SamplePolynomial(PolynomialMethod::NLI, aPoints, aTs, aYs, aCount);
+  };
+}
+
+static void TestTessellationWithinPixelTolerance()
+{
+  AdaptiveTessellator tessellator;
+  auto smallest = 1.0f / (tessellator.mInitialSegments << tessellator.mMaxDepth);
+
+  for (size_t n : { 3, 6, 11 })
+  {
+    for (auto tolerance : { 0.25f, 1.0f, 4.0f })
+    {
+      auto mapping = TestMapping(tolerance);
+      auto points = RandomValues(n, 3.0f, static_cast<unsigned>(n));
+      auto sampler = PolynomialSampler(points);
+
+      std::vector<glm::vec2> curve;
+      CHECK(tessellator.Tessellate(sampler, mapping, curve));
+
+      CHECK(0.0f == curve.front().x);
+      CHECK(1.0f == curve.back().x);
+
+      for (size_t i{ 0 }; i + 1 < curve.size(); ++i)
+      {
+        auto &start = curve[i];
+        auto &end = curve[i + 1];
+        CHECK(start.x < end.x);
+
+        // Only the depth limit is allowed to stop a segment short.
+        if (end.x - start.x <= smallest * 1.5f)
+        {
+          continue;
+        }
+
+        glm::vec2 middle{ 0.5f * (start.x + end.x), 0.0f };
+        sampler(&middle.x, &middle.y, 1);
+
+        auto distance = DistanceToSegment(ToPixels(mapping, middle),
+                                          ToPixels(mapping, start),
+                                          ToPixels(mapping, end));
+
+        CHECK(distance <= tolerance + 0.01f);
+      }
+    }
+  }
+}
+
+static void TestTessellationSkipsOffscreen()
+{
+  AdaptiveTessellator tessellator;
+  auto initial = 1.0f / tessellator.mInitialSegments;
+
+  auto points = RandomValues(11);
+  auto sampler = PolynomialSampler(points);
+  std::vector<glm::vec2> curve;
+
+  // Entirely off the right of the screen, the initial segments are all
+  // there is.
+  auto mapping = TestMapping(0.25f);
+  mapping.mModelViewProjection[3][0] = 5.0f;
+  tessellator.Tessellate(sampler, mapping, curve);
+  CHECK(tessellator.mInitialSegments + 1 == curve.size());
+
+  // Only t < 0.55 is on screen, the 7 initial segments past it keep their
+  // spacing.
+  mapping.mModelViewProjection[0][0] = 4.0f;
+  mapping.mModelViewProjection[3][0] = -1.2f;
+  tessellator.Tessellate(sampler, mapping, curve);
+
+  size_t offscreen{ 0 };
+
+  for (size_t i{ 0 }; i + 1 < curve.size(); ++i)
+  {
+    if (ToPixels(mapping, curve[i]).x > mapping.mViewportSize.x)
+    {
+      CHECK_NEAR(curve[i + 1].x - curve[i].x, initial, 1e-6);
+      ++offscreen;
+    }
+  }
+
+  CHECK(7 == offscreen);
+  CHECK(tessellator.mInitialSegments + 1 < curve.size());
+}
+
+static void TestTessellationOfLine()
+{
+  AdaptiveTessellator tessellator;
+  size_t calls{ 0 };
+
+  CurveSampler line = [&](const float *aTs, float *aYs, size_t aCount)
+  {
+    ++calls;
+
+    for (size_t i{ 0 }; i < aCount; ++i)
+    {
+      aYs[i] = 2.0f * aTs[i] - 1.0f;
+    }
+  };
+
+  for (auto tolerance : { 0.1f, 1.0f })
+  {
+    calls = 0;
+
+    std::vector<glm::vec2> curve;
+    tessellator.Tessellate(line, TestMapping(tolerance), curve);
+
+    // The initial samples, then one round of midpoints that all turn out
+    // flat.
+    CHECK(17 == curve.size());
+    CHECK(2 == calls);
+
+    for (size_t i{ 0 }; i < curve.size(); ++i)
+    {
+      CHECK_NEAR(curve[i].x, i / 16.0, 1e-6);
+      CHECK_NEAR(curve[i].y, 2.0 * i / 16.0 - 1.0, 1e-6);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Bezier curves
+///////////////////////////////////////////////////////////////////////////////////
+static BezierControlPolygon RandomPolygon(size_t aCount, bool a3D, unsigned aSeed = 302)
+{
+  BezierControlPolygon polygon;
+  polygon.mX = RandomValues(aCount, 3.0f, aSeed);
+  polygon.mY = RandomValues(aCount, 3.0f, aSeed + 1);
+
+  if (a3D)
+  {
+    polygon.mZ = RandomValues(aCount, 3.0f, aSeed + 2);
+  }
+
+  return polygon;
+}
+
+// The curve at aT by de Casteljau in double.
+static glm::dvec3 BezierReference(const BezierControlPolygon &aPolygon, double aT)
+{
+  std::vector<glm::dvec3> row(aPolygon.Size());
+
+  for (size_t i{ 0 }; i < row.size(); ++i)
+  {
+    row[i] = glm::dvec3{ aPolygon.Point(i) };
+  }
+
+  for (size_t k{ 1 }; k < row.size(); ++k)
+  {
+    for (size_t i{ 0 }; i < row.size() - k; ++i)
+    {
+      row[i] = (1.0 - aT) * row[i] + aT * row[i + 1];
+    }
+  }
+
+  return row[0];
+}
+
+// Where ScreenMapping puts a point, in pixels.
+static glm::vec2 ToPixels(const ScreenMapping &aMapping, glm::vec3 aPoint)
+{
+  auto clip = aMapping.mModelViewProjection * glm::vec4{ aPoint, 1.0f };
+  glm::vec2 ndc{ clip.x / clip.w, clip.y / clip.w };
+
+  return (ndc * 0.5f + 0.5f) * aMapping.mViewportSize;
+}
+
+// Up to cBezierBasisThreshold points BezierEvaluator runs de Casteljau, past
+// it the Bernstein basis. Both have to stay on the curve either side.
+static void TestBezierEvaluatorAcrossBasisThreshold()
+{
+  std::vector<float> ts;
+  UniformSamples(257, ts);
+
+  std::vector<float> xs(ts.size());
+  std::vector<float> ys(ts.size());
+  std::vector<float> zs(ts.size());
+  BezierEvaluator evaluator;
+
+  for (auto is3D : { false, true })
+  {
+    for (size_t n : { cBezierBasisThreshold - 1, cBezierBasisThreshold, cBezierBasisThreshold + 1, size_t{ 1000 } })
+    {
+      auto polygon = RandomPolygon(n, is3D, static_cast<unsigned>(n));
+      evaluator.Evaluate(polygon, ts.data(), ts.size(), xs.data(), ys.data(), is3D ? zs.data() : nullptr);
+
+      for (size_t i{ 0 }; i < ts.size(); ++i)
+      {
+        auto expected = BezierReference(polygon, ts[i]);
+
+        CHECK_NEAR(xs[i], expected.x, 1e-5);
+        CHECK_NEAR(ys[i], expected.y, 1e-5);
+
+        if (is3D)
+        {
+          CHECK_NEAR(zs[i], expected.z, 1e-5);
+        }
+      }
+    }
+
+    // Raising the degree keeps the curve but moves it to the other path, so
+    // the two can be compared directly.
+    auto polygon = RandomPolygon(cBezierBasisThreshold, is3D);
+    BezierControlPolygon elevated;
+    auto n = polygon.Size();
+
+    for (auto coordinates : { std::make_pair(&polygon.mX, &elevated.mX),
+                              std::make_pair(&polygon.mY, &elevated.mY),
+                              std::make_pair(&polygon.mZ, &elevated.mZ) })
+    {
+      auto &from = *coordinates.first;
+      auto &to = *coordinates.second;
+
+      if (from.empty())
+      {
+        continue;
+      }
+
+      to.resize(n + 1);
+      to.front() = from.front();
+      to.back() = from.back();
+
+      for (size_t i{ 1 }; i < n; ++i)
+      {
+        auto a = static_cast<double>(i) / n;
+        to[i] = static_cast<float>(a * from[i - 1] + (1.0 - a) * from[i]);
+      }
+    }
+
+    std::vector<float> elevatedXs(ts.size());
+    std::vector<float> elevatedYs(ts.size());
+    std::vector<float> elevatedZs(ts.size());
+
+    evaluator.Evaluate(polygon, ts.data(), ts.size(), xs.data(), ys.data(), zs.data());
+    evaluator.Evaluate(elevated, ts.data(), ts.size(), elevatedXs.data(), elevatedYs.data(), elevatedZs.data());
+
+    for (size_t i{ 0 }; i < ts.size(); ++i)
+    {
+      CHECK_NEAR(elevatedXs[i], xs[i], 1e-5);
+      CHECK_NEAR(elevatedYs[i], ys[i], 1e-5);
+
+      if (is3D)
+      {
+        CHECK_NEAR(elevatedZs[i], zs[i], 1e-5);
+      }
+    }
+  }
+}
+
+static void TestSplitBezierHalvesMatchCurve()
+{
+  for (auto is3D : { false, true })
+  {
+    for (size_t n : { 1, 2, 3, 4, 10, 30 })
+    {
+      auto polygon = RandomPolygon(n, is3D);
+      auto triangle = polygon;
+      BezierControlPolygon left;
+      BezierControlPolygon right;
+      std::vector<glm::vec3> shells;
+
+      SplitBezier(triangle, left, right, &shells);
+
+      CHECK(n == left.Size());
+      CHECK(n == right.Size());
+      CHECK(is3D == left.Is3D());
+      CHECK(is3D == right.Is3D());
+
+      // Every row of the triangle below the polygon, as line segments.
+      CHECK((n > 1 ? (n - 1) * (n - 2) : 0) == shells.size());
+
+      for (int k{ 0 }; k <= 20; ++k)
+      {
+        auto u = k / 20.0;
+        auto expectedLeft = BezierReference(polygon, 0.5 * u);
+        auto expectedRight = BezierReference(polygon, 0.5 + 0.5 * u);
+        auto actualLeft = BezierReference(left, u);
+        auto actualRight = BezierReference(right, u);
+
+        for (int axis{ 0 }; axis < 3; ++axis)
+        {
+          CHECK_NEAR(actualLeft[axis], expectedLeft[axis], 1e-5);
+          CHECK_NEAR(actualRight[axis], expectedRight[axis], 1e-5);
+        }
+      }
+
+      // The halves meet on the curve.
+      if (0 < n)
+      {
+        CHECK(left.Point(n - 1) == right.Point(0));
+      }
+    }
+  }
+}
+
+static void TestSubdivisionWithinPixelTolerance()
+{
+  // Random points in [-3, 3] end up in [-0.9, 0.9] of the screen.
+  ScreenMapping mapping{ glm::mat4{ 1.0f }, { 1280.0f, 720.0f }, 0.5f };
+  mapping.mModelViewProjection[0][0] = 0.3f;
+  mapping.mModelViewProjection[1][1] = 0.3f;
+
+  std::vector<float> ts;
+  UniformSamples(2000, ts);
+
+  for (auto is3D : { false, true })
+  {
+    for (size_t n : { 2, 3, 5, 12, 40 })
+    {
+      for (auto tolerance : { 0.25f, 1.0f, 4.0f })
+      {
+        mapping.mPixelTolerance = tolerance;
+
+        auto polygon = RandomPolygon(n, is3D, static_cast<unsigned>(n));
+        BezierSubdivider subdivider;
+        std::vector<glm::vec3> curve;
+        subdivider.Subdivide(polygon, mapping, curve);
+
+        CHECK(curve.front() == polygon.Point(0));
+        CHECK(curve.back() == polygon.Point(n - 1));
+
+        std::vector<glm::vec2> pixels;
+
+        for (auto &point : curve)
+        {
+          pixels.push_back(ToPixels(mapping, point));
+        }
+
+        std::vector<float> xs(ts.size());
+        std::vector<float> ys(ts.size());
+        std::vector<float> zs(ts.size());
+        BezierEvaluator evaluator;
+        evaluator.Evaluate(polygon, ts.data(), ts.size(), xs.data(), ys.data(), zs.data());
+
+        float furthest{ 0.0f };
+
+        for (size_t i{ 0 }; i < ts.size(); ++i)
+        {
+          auto sample = ToPixels(mapping, { xs[i], ys[i], is3D ? zs[i] : 0.0f });
+          auto nearest = std::numeric_limits<float>::max();
+
+          for (size_t j{ 0 }; j + 1 < pixels.size(); ++j)
+          {
+            nearest = std::min(nearest, DistanceToSegment(sample, pixels[j], pixels[j + 1]));
+          }
+
+          furthest = std::max(furthest, nearest);
+        }
+
+        // A little slack for the float round trip through the MVP.
+        CHECK(furthest <= tolerance + 0.01f);
+      }
+    }
+  }
+}
+
+static void TestSubdivisionShellDepth()
+{
+  ScreenMapping mapping{ glm::mat4{ 1.0f }, { 1280.0f, 720.0f }, 0.1f };
+  mapping.mModelViewProjection[0][0] = 0.3f;
+  mapping.mModelViewProjection[1][1] = 0.3f;
+
+  // Curvy enough at this tolerance that both halves get split again.
+  size_t n{ 6 };
+  auto polygon = RandomPolygon(n, false);
+  auto triangleLines = n * (n - 1) / 2;
+
+  BezierSubdivider subdivider;
+  std::vector<glm::vec3> curve;
+  std::vector<glm::vec3> shells;
+
+  subdivider.Subdivide(polygon, mapping, curve, &shells, 0);
+  CHECK(shells.empty());
+
+  // The control polygon and the first split's rows, nothing deeper.
+  subdivider.Subdivide(polygon, mapping, curve, &shells, 1);
+  CHECK(2 * triangleLines == shells.size());
+
+  for (size_t i{ 0 }; i + 1 < n; ++i)
+  {
+    CHECK(shells[2 * i] == polygon.Point(i));
+    CHECK(shells[2 * i + 1] == polygon.Point(i + 1));
+  }
+
+  // Adds both halves' triangles.
+  shells.clear();
+  subdivider.Subdivide(polygon, mapping, curve, &shells, 2);
+  CHECK(2 * 3 * triangleLines == shells.size());
+
+  // The shells don't change the curve.
+  std::vector<glm::vec3> withoutShells;
+  subdivider.Subdivide(polygon, mapping, withoutShells);
+  CHECK(withoutShells == curve);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Interpolation
+///////////////////////////////////////////////////////////////////////////////////
+static void TestNewtonInterpolates()
+{
+  for (size_t n : { 1, 2, 5, 12 })
+  {
+    std::vector<double> xs;
+    EquallySpacedNodes(n, xs);
+
+    auto values = RandomValues(n);
+    std::vector<double> ys(values.begin(), values.end());
+
+    NewtonInterpolator interpolator;
+    interpolator.Build(xs, ys);
+
+    for (size_t i{ 0 }; i < n; ++i)
+    {
+      CHECK_NEAR(interpolator.Evaluate(xs[i]), ys[i], 1e-9);
+    }
+
+    // Moving one value has to end up where a rebuild would.
+    if (n > 1)
+    {
+      interpolator.SetValue(n / 2, 2.5);
+      ys[n / 2] = 2.5;
+
+      NewtonInterpolator rebuilt;
+      rebuilt.Build(xs, ys);
+
+      for (double x : { 0.0, 0.3, 0.61, 1.0 })
+      {
+        CHECK_NEAR(interpolator.Evaluate(x), rebuilt.Evaluate(x), 1e-9);
+      }
+    }
+  }
+}
+
+// SyncInterpolator is what Project 3 calls every frame, a dragged point has
+// to be one O(n) SetValue even for a handful of points.
+static void TestSyncInterpolatorMovesOnePoint()
+{
+  for (size_t n : { 2, 3, 7, 8, 16 })
+  {
+    std::vector<double> xs;
+    EquallySpacedNodes(n, xs);
+    auto ys = RandomValues(n);
+
+    NewtonInterpolator interpolator;
+    CHECK(SyncInterpolator(interpolator, xs, ys));
+    CHECK(0 == interpolator.UpdatesSinceBuild());
+    CHECK(false == SyncInterpolator(interpolator, xs, ys));
+
+    ys[n / 2] = 2.5f;
+    CHECK(SyncInterpolator(interpolator, xs, ys));
+    CHECK(1 == interpolator.UpdatesSinceBuild());
+
+    NewtonInterpolator rebuilt;
+    rebuilt.Build(xs, std::vector<double>(ys.begin(), ys.end()));
+
+    for (size_t i{ 0 }; i < n; ++i)
+    {
+      auto expected = rebuilt.Coefficients()[i];
+      CHECK_NEAR(interpolator.Coefficients()[i], expected, 1e-9 * std::max(1.0, std::fabs(expected)));
+    }
+
+    for (double x : { 0.0, 0.3, 0.61, 1.0 })
+    {
+      CHECK_NEAR(interpolator.Evaluate(x), rebuilt.Evaluate(x), 1e-9);
+    }
+
+    // Moving every point is cheaper to rebuild.
+    for (auto &y : ys)
+    {
+      y += 1.0f;
+    }
+
+    CHECK(SyncInterpolator(interpolator, xs, ys));
+    CHECK(0 == interpolator.UpdatesSinceBuild());
+  }
+}
+
+static void TestBarycentricMatchesNewton()
+{
+  for (size_t n : { 2, 3, 7, 15 })
+  {
+    std::vector<double> xs;
+    EquallySpacedNodes(n, xs);
+
+    auto values = RandomValues(n);
+    std::vector<double> ys(values.begin(), values.end());
+
+    NewtonInterpolator newton;
+    newton.Build(xs, ys);
+
+    BarycentricInterpolator barycentric;
+    barycentric.SetNodes(xs);
+    barycentric.SetValues(ys);
+
+    std::vector<float> ts;
+    UniformSamples(257, ts);
+    std::vector<float> batch(ts.size());
+    barycentric.Evaluate(ts.data(), batch.data(), ts.size());
+
+    for (size_t i{ 0 }; i < ts.size(); ++i)
+    {
+      CHECK_NEAR(barycentric.Evaluate(ts[i]), newton.Evaluate(ts[i]), 1e-9);
+      CHECK_NEAR(batch[i], newton.Evaluate(ts[i]), 1e-5);
+    }
+
+    // Exactly on a node the formula is 0 / 0.
+    for (size_t i{ 0 }; i < n; ++i)
+    {
+      CHECK(barycentric.Evaluate(xs[i]) == ys[i]);
+    }
+  }
+}
+
+static void TestBarycentricChebyshevIsStable()
+{
+  // Runge's function, hopeless at evenly spaced nodes of this degree.
+  auto runge = [](double aT) { auto x = 2.0 * aT - 1.0; return 1.0 / (1.0 + 25.0 * x * x); };
+
+  for (size_t n : { 200, 1000 })
+  {
+    std::vector<double> xs;
+    ChebyshevNodes(n, xs);
+
+    CHECK(0.0 == xs.front());
+    CHECK(1.0 == xs.back());
+
+    std::vector<double> ys(n);
+
+    for (size_t i{ 0 }; i < n; ++i)
+    {
+      ys[i] = runge(xs[i]);
+    }
+
+    BarycentricInterpolator interpolator;
+    interpolator.SetNodes(xs);
+    interpolator.SetValues(ys);
+
+    for (int k{ 0 }; k <= 1000; ++k)
+    {
+      auto t = k / 1000.0;
+      CHECK_NEAR(interpolator.Evaluate(t), runge(t), 1e-7);
+    }
+  }
+}
+
+static void TestSplineNatural()
+{
+  std::vector<double> xs;
+  EquallySpacedNodes(10, xs);
+
+  auto values = RandomValues(xs.size());
+  std::vector<double> ys(values.begin(), values.end());
+
+  CubicSpline spline;
+  spline.SetKnots(xs, SplineEnd::Natural);
+  spline.SetValues(ys);
+  spline.Solve();
+
+  for (size_t i{ 0 }; i < xs.size(); ++i)
+  {
+    CHECK_NEAR(spline.Evaluate(xs[i]), ys[i], 1e-12);
+  }
+
+  CHECK(0.0 == spline.Moments().front());
+  CHECK(0.0 == spline.Moments().back());
+
+  // C1 across an interior knot.
+  auto h = 1e-6;
+  auto x = xs[4];
+  auto left = (spline.Evaluate(x) - spline.Evaluate(x - h)) / h;
+  auto right = (spline.Evaluate(x + h) - spline.Evaluate(x)) / h;
+  CHECK_NEAR(left, right, 1e-3);
+
+  // Solving again after a move matches factoring from scratch.
+  spline.SetValue(3, -1.0);
+  spline.Solve();
+  ys[3] = -1.0;
+
+  CubicSpline fresh;
+  fresh.SetKnots(xs, SplineEnd::Natural);
+  fresh.SetValues(ys);
+  fresh.Solve();
+
+  for (size_t i{ 0 }; i < xs.size(); ++i)
+  {
+    CHECK_NEAR(spline.Moments()[i], fresh.Moments()[i], 1e-9);
+  }
+}
+
+static void TestSplineClampedReproducesCubic()
+{
+  auto f = [](double aX) { return aX * aX * aX - 2.0 * aX + 0.5; };
+
+  std::vector<double> xs;
+  EquallySpacedNodes(7, xs);
+
+  std::vector<double> ys(xs.size());
+
+  for (size_t i{ 0 }; i < xs.size(); ++i)
+  {
+    ys[i] = f(xs[i]);
+  }
+
+  CubicSpline spline;
+  spline.SetKnots(xs, SplineEnd::Clamped);
+  spline.SetValues(ys);
+  spline.SetEndSlopes(-2.0, 1.0);
+  spline.Solve();
+
+  for (int k{ 0 }; k <= 100; ++k)
+  {
+    auto x = k / 100.0;
+    CHECK_NEAR(spline.Evaluate(x), f(x), 1e-12);
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Picking
+///////////////////////////////////////////////////////////////////////////////////
+static void TestPickControlPoint()
+{
+  // Evenly spaced over [0, 1], so 0.25 apart.
+  std::vector<float> ys = { 0.0f, 1.0f, -1.0f, 2.0f, 0.5f };
+
+  CHECK(1 == PickControlPoint(ys, { 0.26f, 0.98f }, 0.06f));
+  CHECK(4 == PickControlPoint(ys, { 1.0f, 0.5f }, 0.06f));
+  CHECK(-1 == PickControlPoint(ys, { 0.5f, 1.0f }, 0.06f));
+  CHECK(-1 == PickControlPoint(ys, { 0.125f, 0.0f }, 0.06f));
+
+  // The closest of several in range wins.
+  std::vector<float> crowded = { 0.0f, 0.05f, 0.1f };
+  std::vector<float> crowdedXs = { 0.0f, 0.02f, 0.04f };
+  CHECK(2 == PickControlPoint(crowded, crowdedXs, { 0.041f, 0.09f }, 0.06f));
+
+  std::vector<float> xs = { 0.0f, 0.1f, 1.0f };
+  std::vector<float> unevenYs = { 0.0f, 1.0f, 0.0f };
+  CHECK(1 == PickControlPoint(unevenYs, xs, { 0.11f, 0.98f }, 0.06f));
+  CHECK(-1 == PickControlPoint(unevenYs, xs, { 0.5f, 0.0f }, 0.06f));
+  CHECK(2 == PickControlPoint(unevenYs, xs, { 0.99f, 0.01f }, 0.06f));
+
+  BezierControlPolygon polygon;
+  polygon.mX = { 0.5f, -1.0f, 2.0f };
+  polygon.mY = { 0.5f, 1.0f, -2.0f };
+  CHECK(1 == PickControlPoint(polygon, { -1.02f, 1.01f }, 0.06f));
+  CHECK(-1 == PickControlPoint(polygon, { 0.0f, 0.0f }, 0.06f));
+
+  CHECK(-1 == PickControlPoint(std::vector<float>{}, { 0.0f, 0.0f }, 0.06f));
+}
+
+// Picking has to agree with where the points are drawn.
+static void TestPickLaidOutPoints()
+{
+  auto ys = RandomValues(50);
+
+  std::vector<double> nodes;
+  ChebyshevNodes(ys.size(), nodes);
+  std::vector<float> chebyshevXs(nodes.begin(), nodes.end());
+
+  for (auto *xs : { &chebyshevXs, static_cast<std::vector<float>*>(nullptr) })
+  {
+    std::vector<glm::vec3> points;
+    LayoutFunctionPoints(ys, xs ? *xs : std::vector<float>{}, points);
+
+    CHECK(points.size() == ys.size());
+
+    for (size_t i{ 0 }; i < points.size(); ++i)
+    {
+      glm::vec2 position{ points[i].x, points[i].y };
+      auto picked = xs ? PickControlPoint(ys, *xs, position, 0.001f)
+                       : PickControlPoint(ys, position, 0.001f);
+
+      CHECK(static_cast<int>(i) == picked);
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// ThreadPool
+///////////////////////////////////////////////////////////////////////////////////
+static void TestParallelForCoversEveryIndexOnce()
+{
+  ThreadPool pool{ 3 };
+
+  for (size_t count : { 0, 1, 7, 2048, 2049, 100000 })
+  {
+    for (size_t grain : { 1, 64, 2048 })
+    {
+      for (size_t threads : { 0, 1, 2 })
+      {
+        std::vector<std::atomic<int>> visits(count);
+
+        for (auto &visit : visits)
+        {
+          visit = 0;
+        }
+
+        pool.ParallelFor(count, grain, [&](size_t aBegin, size_t aEnd)
+        {
+          CHECK(aBegin < aEnd);
+          CHECK(aEnd <= count);
+
+          for (auto i{ aBegin }; i < aEnd; ++i)
+          {
+            ++visits[i];
+          }
+        }, threads);
+
+        auto once = std::all_of(visits.begin(), visits.end(), [](const std::atomic<int> &aVisit)
+        {
+          return 1 == aVisit.load();
+        });
+
+        CHECK(once);
+      }
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// Async evaluation
+///////////////////////////////////////////////////////////////////////////////////
+static void TestTripleBufferHandsOverNewest()
+{
+  TripleBuffer<int> buffer;
+  CHECK(false == buffer.Update());
+
+  buffer.Back() = 1;
+  buffer.Publish();
+  buffer.Back() = 2;
+  buffer.Publish();
+
+  // 1 was overwritten before the reader got to it.
+  CHECK(buffer.Update());
+  CHECK(2 == buffer.Front());
+  CHECK(false == buffer.Update());
+  CHECK(2 == buffer.Front());
+
+  buffer.Back() = 3;
+  buffer.Publish();
+  CHECK(buffer.Update());
+  CHECK(3 == buffer.Front());
+
+  // Across threads the reader may skip values but never goes backwards or
+  // sees one half written.
+  constexpr int cCount{ 100000 };
+  TripleBuffer<std::vector<int>> values;
+
+  std::thread writer([&]()
+  {
+    for (int i{ 1 }; i <= cCount; ++i)
+    {
+      values.Back().assign(16, i);
+      values.Publish();
+    }
+  });
+
+  int last{ 0 };
+
+  while (last < cCount)
+  {
+    if (values.Update())
+    {
+      auto &front = values.Front();
+      CHECK(16 == front.size());
+      CHECK(std::all_of(front.begin(), front.end(), [&](int aValue) { return aValue == front[0]; }));
+      CHECK(last < front[0]);
+      last = front[0];
+    }
+  }
+
+  writer.join();
+  CHECK(false == values.Update());
+}
+
+static PolynomialCurveInput TestCurveInput(size_t aPoints, size_t aRevision)
+{
+  PolynomialCurveInput input;
+  input.mPoints = MakeSnapshot(RandomValues(aPoints, 3.0f, static_cast<unsigned>(aRevision)));
+  input.mMethod = PolynomialMethod::NLI;
+  input.mMapping = TestMapping();
+  input.mSamples = 2;
+  input.mRevision = aRevision;
+
+  return input;
+}
+
+static void WaitUntilIdle(const AsyncPolynomialEvaluator &aEvaluator)
+{
+  while (aEvaluator.Busy())
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+}
+
+static void TestAsyncEvaluatorKeepsLastSubmission()
+{
+  ThreadPool pool{ 1 };
+  AsyncPolynomialEvaluator evaluator{ pool };
+
+  CHECK(false == evaluator.Update());
+
+  for (size_t revision{ 1 }; revision <= 50; ++revision)
+  {
+    evaluator.Submit(TestCurveInput(200, revision));
+  }
+
+  WaitUntilIdle(evaluator);
+
+  CHECK(evaluator.Update());
+  CHECK(50 == evaluator.Latest().mInput.mRevision);
+
+  // And it's the curve of that input, not a cancelled one's.
+  PolynomialCurveEvaluator synchronous{ nullptr };
+  std::vector<glm::vec2> expected;
+  synchronous.Evaluate(TestCurveInput(200, 50), expected);
+
+  CHECK(expected == evaluator.Latest().mPoints);
+}
+
+// Submitting faster than a curve evaluates cancels the running job every
+// time, but the one after a cancelled job has to finish.
+static void TestAsyncEvaluatorFinishesUnderConstantSubmits()
+{
+  ThreadPool pool{ 1 };
+  AsyncPolynomialEvaluator evaluator{ pool };
+
+  auto start = std::chrono::steady_clock::now();
+  size_t revision{ 0 };
+  bool published{ false };
+
+  while (false == published && std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+  {
+    evaluator.Submit(TestCurveInput(1000, ++revision));
+    std::this_thread::sleep_for(std::chrono::microseconds(200));
+    published = evaluator.Update();
+  }
+
+  CHECK(published);
+  CHECK(evaluator.Latest().mInput.mRevision < revision);
+  CHECK(false == evaluator.Latest().mPoints.empty());
+
+  WaitUntilIdle(evaluator);
+  CHECK(evaluator.Update());
+  CHECK(revision == evaluator.Latest().mInput.mRevision);
+}
+
+// The destructor has to wait for the running job, which still points at it.
+static void TestAsyncEvaluatorDestroyedMidJob()
+{
+  ThreadPool pool{ 1 };
+
+  for (size_t i{ 0 }; i < 20; ++i)
+  {
+    auto evaluator = std::make_unique<AsyncPolynomialEvaluator>(pool);
+    evaluator->Submit(TestCurveInput(1000, i + 1));
+    evaluator->Submit(TestCurveInput(1000, i + 2));
+
+    if (i % 2)
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    evaluator.reset();
+  }
+
+  // The pool is still usable afterwards.
+  std::atomic<int> ran{ 0 };
+  pool.ParallelFor(100, 1, [&](size_t aBegin, size_t aEnd) { ran += static_cast<int>(aEnd - aBegin); });
+  CHECK(100 == ran);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// ShadowBuffer
+///////////////////////////////////////////////////////////////////////////////////
+static void TestShadowBufferUploadsOnlyChanges()
+{
+  // The size of the renderer's PackedVertex.
+  using Vertex = glm::vec4;
+
+  ShadowBuffer buffer;
+  std::vector<Vertex> vertices(100, Vertex{ 1.0f });
+
+  auto update = buffer.Update(vertices.data(), sizeof(Vertex) * vertices.size());
+  CHECK(update.mReallocate);
+  CHECK(0 == update.mOffset);
+  CHECK(sizeof(Vertex) * 100 == update.mSize);
+  CHECK(1 == buffer.Allocations());
+
+  // Nothing changed, nothing goes to the driver.
+  update = buffer.Update(vertices.data(), sizeof(Vertex) * vertices.size());
+  CHECK(false == update.mReallocate);
+  CHECK(0 == update.mSize);
+  CHECK(sizeof(Vertex) * 100 == buffer.BytesUploaded());
+
+  // Moving one point uploads just that vertex, same size never reallocates.
+  vertices[42].y = 3.0f;
+  update = buffer.Update(vertices.data(), sizeof(Vertex) * vertices.size());
+  CHECK(false == update.mReallocate);
+  CHECK(sizeof(Vertex) * 42 <= update.mOffset);
+  CHECK(update.mOffset + update.mSize <= sizeof(Vertex) * 43);
+  CHECK(0 < update.mSize);
+  CHECK(1 == buffer.Allocations());
+
+  // Shrinking and growing back within the capacity doesn't reallocate either.
+  update = buffer.Update(vertices.data(), sizeof(Vertex) * 50);
+  CHECK(false == update.mReallocate);
+  CHECK(0 == update.mSize);
+
+  update = buffer.Update(vertices.data(), sizeof(Vertex) * 100);
+  CHECK(false == update.mReallocate);
+  CHECK(sizeof(Vertex) * 50 == update.mOffset);
+  CHECK(sizeof(Vertex) * 50 == update.mSize);
+
+  CHECK(buffer.Contents().size() == sizeof(Vertex) * 100);
+  CHECK(std::equal(buffer.Contents().begin(), buffer.Contents().end(),
+                   reinterpret_cast<const unsigned char*>(vertices.data())));
+}
+
+static void TestShadowBufferGrowsGeometrically()
+{
+  ShadowBuffer buffer;
+  std::vector<unsigned char> data;
+  size_t capacity{ 0 };
+
+  // A curve gaining a vertex a frame.
+  for (size_t size{ 16 }; size <= 16 * 10000; size += 16)
+  {
+    data.resize(size, static_cast<unsigned char>(size));
+    auto update = buffer.Update(data.data(), data.size());
+
+    CHECK(update.mReallocate == (size > capacity));
+
+    if (update.mReallocate)
+    {
+      CHECK(update.mCapacity >= std::max(size, 2 * capacity));
+      CHECK(0 == update.mOffset);
+      CHECK(size == update.mSize);
+      capacity = update.mCapacity;
+    }
+    else
+    {
+      // Only the new vertex is uploaded.
+      CHECK(size - 16 == update.mOffset);
+      CHECK(16 == update.mSize);
+    }
+
+    CHECK(capacity == buffer.Capacity());
+  }
+
+  // Doubling from one vertex to 10000 of them.
+  CHECK(buffer.Allocations() <= 15);
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// main
+///////////////////////////////////////////////////////////////////////////////////
+struct Test
+{
+  const char *mName;
+  void (*mFunction)();
+};
+
+static const Test cTests[] = {
+  { "BernsteinMatchesDeCasteljau", TestBernsteinMatchesDeCasteljau },
+  { "SimdKernelsMatchScalar", TestSimdKernelsMatchScalar },
+  { "BernsteinBasisSumsToOne", TestBernsteinBasisSumsToOne },
+  { "BernstienPolynomialMatchesBasis", TestBernstienPolynomialMatchesBasis },
+  { "ForwardDifferencesMatchDeCasteljau", TestForwardDifferencesMatchDeCasteljau },
+  { "TessellationWithinPixelTolerance", TestTessellationWithinPixelTolerance },
+  { "TessellationSkipsOffscreen", TestTessellationSkipsOffscreen },
+  { "TessellationOfLine", TestTessellationOfLine },
+  { "BezierEvaluatorAcrossBasisThreshold", TestBezierEvaluatorAcrossBasisThreshold },
+  { "SplitBezierHalvesMatchCurve", TestSplitBezierHalvesMatchCurve },
+  { "SubdivisionWithinPixelTolerance", TestSubdivisionWithinPixelTolerance },
+  { "SubdivisionShellDepth", TestSubdivisionShellDepth },
+  { "NewtonInterpolates", TestNewtonInterpolates },
+  { "SyncInterpolatorMovesOnePoint", TestSyncInterpolatorMovesOnePoint },
+  { "BarycentricMatchesNewton", TestBarycentricMatchesNewton },
+  { "BarycentricChebyshevIsStable", TestBarycentricChebyshevIsStable },
+  { "SplineNatural", TestSplineNatural },
+  { "SplineClampedReproducesCubic", TestSplineClampedReproducesCubic },
+  { "PickControlPoint", TestPickControlPoint },
+  { "PickLaidOutPoints", TestPickLaidOutPoints },
+  { "ParallelForCoversEveryIndexOnce", TestParallelForCoversEveryIndexOnce },
+  { "TripleBufferHandsOverNewest", TestTripleBufferHandsOverNewest },
+  { "AsyncEvaluatorKeepsLastSubmission", TestAsyncEvaluatorKeepsLastSubmission },
+  { "AsyncEvaluatorFinishesUnderConstantSubmits", TestAsyncEvaluatorFinishesUnderConstantSubmits },
+  { "AsyncEvaluatorDestroyedMidJob", TestAsyncEvaluatorDestroyedMidJob },
+  { "ShadowBufferUploadsOnlyChanges", TestShadowBufferUploadsOnlyChanges },
+  { "ShadowBufferGrowsGeometrically", TestShadowBufferGrowsGeometrically },
+};
+
+int main()
+{
+  int failedTests{ 0 };
+
+  for (auto &test : cTests)
+  {
+    auto failuresBefore = gFailures;
+
+    test.mFunction();
+
+    auto passed = failuresBefore == gFailures;
+    failedTests += passed ? 0 : 1;
+
+    std::printf("%s %s\n", passed ? "[ passed ]" : "[ FAILED ]", test.mName);
+  }
+
+  std::printf("%d of %d tests failed\n", failedTests, static_cast<int>(std::size(cTests)));
+
+  return (0 == failedTests) ? 0 : 1;
+}
@@ -0,0 +1,221 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+#include "ThreadPool.hpp"
+
+ThreadPool::ThreadPool(size_t aWorkers)
+  : mStopping(false)
+{
+  if (0 == aWorkers)
+  {
+    auto hardware = static_cast<size_t>(std::thread::hardware_concurrency());
+    aWorkers = std::max<size_t>(hardware, 2) - 1;
+  }
+
+  for (size_t i{ 0 }; i < aWorkers; ++i)
+  {
+    mWorkers.emplace_back([this]() { WorkerLoop(); });
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStopping = true;
+  }
+
+  mWake.notify_all();
+
+  for (auto &worker : mWorkers)
+  {
+    worker.join();
+  }
+}
+
+void ThreadPool::Enqueue(Job aJob)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mJobs.push_back(std::move(aJob));
+  }
+
+  mWake.notify_one();
+}
+
+ThreadPool& ThreadPool::Shared()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+///////////////////////////////////////////////////////////////////////////////////
+// ParallelFor
+///////////////////////////////////////////////////////////////////////////////////
+namespace
+{
+  // The chunks one thread has left, packed so they can be swapped at once.
+  struct alignas(64) ChunkRange
+  {
+    std::atomic<std::uint64_t> mRange{ 0 };
+  };
+
+  constexpr std::uint64_t Pack(std::uint64_t aBegin, std::uint64_t aEnd)
+  {
+    return aBegin | (aEnd << 32);
+  }
+
+  constexpr std::uint64_t Begin(std::uint64_t aRange)
+  {
+    return aRange & 0xFFFFFFFF;
+  }
+
+  constexpr std::uint64_t End(std::uint64_t aRange)
+  {
+    return aRange >> 32;
+  }
+
+  struct ParallelForState
+  {
+    ParallelForState(size_t aCount, size_t aGrain, size_t aThreads, const ThreadPool::RangeBody &aBody)
+      : mCount(aCount)
+      , mGrain(aGrain)
+      , mChunks((aCount + aGrain - 1) / aGrain)
+      , mRanges(aThreads)
+      , mDone(0)
+      , mBody(aBody)
+    {
+      for (size_t i{ 0 }; i < aThreads; ++i)
+      {
+        mRanges[i].mRange = Pack(mChunks * i / aThreads, mChunks * (i + 1) / aThreads);
+      }
+    }
+
+    bool TakeOwn(size_t aThread, std::uint64_t &aChunk)
+    {
+      auto &range = mRanges[aThread].mRange;
+      auto current = range.load(std::memory_order_relaxed);
+
+      while (Begin(current) < End(current))
+      {
+        if (range.compare_exchange_weak(current, Pack(Begin(current) + 1, End(current))))
+        {
+          aChunk = Begin(current);
+          return true;
+        }
+      }
+
+      return false;
+    }
+
+    // Moves the back half of another thread's chunks into ours.
+    bool Steal(size_t aThread)
+    {
+      for (size_t offset{ 1 }; offset < mRanges.size(); ++offset)
+      {
+        auto &victim = mRanges[(aThread + offset) % mRanges.size()].mRange;
+        auto current = victim.load(std::memory_order_relaxed);
+
+        while (Begin(current) < End(current))
+        {
+          auto begin = Begin(current);
+          auto end = End(current);
+          auto middle = begin + (end - begin) / 2;
+
+          if (victim.compare_exchange_weak(current, Pack(begin, middle)))
+          {
+            // Ours is empty, so nobody else will be changing it.
+            mRanges[aThread].mRange.store(Pack(middle, end));
+            return true;
+          }
+        }
+      }
+
+      return false;
+    }
+
+    void Work(size_t aThread)
+    {
+      std::uint64_t chunk;
+
+      do
+      {
+        while (TakeOwn(aThread, chunk))
+        {
+          auto begin = static_cast<size_t>(chunk) * mGrain;
+          mBody(begin, std::min(begin + mGrain, mCount));
+          mDone.fetch_add(1, std::memory_order_release);
+        }
+      } while (Steal(aThread));
+    }
+
+    size_t mCount;
+    size_t mGrain;
+    size_t mChunks;
+    std::vector<ChunkRange> mRanges;
+    std::atomic<size_t> mDone;
+    const ThreadPool::RangeBody &mBody;
+  };
+}
+
+void ThreadPool::ParallelFor(size_t aCount, size_t aGrain, const RangeBody &aBody, size_t aThreads)
+{
+  aGrain = std::max<size_t>(aGrain, 1);
+
+  auto chunks = (aCount + aGrain - 1) / aGrain;
+  auto threads = (0 == aThreads) ? (WorkerCount() + 1) : std::min(aThreads, WorkerCount() + 1);
+  threads = std::min(threads, chunks);
+
+  if (threads <= 1)
+  {
+    if (0 != aCount)
+    {
+      aBody(0, aCount);
+    }
+
+    return;
+  }
+
+  // Workers that only get to run after everything's done still touch the
+  // state, so it's shared with them instead of living on this stack. They
+  // find no chunks left and never call aBody.
+  auto state = std::make_shared<ParallelForState>(aCount, aGrain, threads, aBody);
+
+  for (size_t i{ 1 }; i < threads; ++i)
+  {
+    Enqueue([state, i]() { state->Work(i); });
+  }
+
+  state->Work(0);
+
+  // Everything's been taken, wait for whoever's still finishing a chunk.
+  while (state->mDone.load(std::memory_order_acquire) != state->mChunks)
+  {
+    std::this_thread::yield();
+  }
+}
+
+void ThreadPool::WorkerLoop()
+{
+  while (true)
+  {
+    Job job;
+
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWake.wait(lock, [this]() { return mStopping || false == mJobs.empty(); });
+
+      if (mJobs.empty())
+      {
+        return;
+      }
+
+      job = std::move(mJobs.front());
+      mJobs.pop_front();
+    }
+
+    job();
+  }
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads running jobs off a shared queue.
+class ThreadPool
+{
+public:
+  using Job = std::function<void()>;
+
+  // Called with a [begin, end) range of indices to process.
+  using RangeBody = std::function<void(size_t aBegin, size_t aEnd)>;
+
+  // Defaults to one worker per hardware thread, less the one rendering.
+  explicit ThreadPool(size_t aWorkers = 0);
+
+  // Finishes every queued job before returning.
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  void Enqueue(Job aJob);
+
+  // Runs aBody over [0, aCount) in chunks of aGrain indices, on the calling
+  // thread plus up to aThreads - 1 workers (0 meaning all of them). Returns
+  // once every index has been processed.
+  //
+  // Each thread starts with an even share of the chunks and takes them one
+  // at a time from the front. A thread that runs out steals the back half of
+  // someone else's share, so uneven chunks still finish together. Shares are
+  // a single packed [begin, end) atomic, so taking and stealing are both a
+  // compare and swap. The calling thread always takes part, so this is safe
+  // to call from inside a job on this same pool.
+  void ParallelFor(size_t aCount, size_t aGrain, const RangeBody &aBody, size_t aThreads = 0);
+
+  size_t WorkerCount() const { return mWorkers.size(); }
+
+  // Pool shared by everything in the application.
+  static ThreadPool& Shared();
+
+private:
+  void WorkerLoop();
+
+  std::mutex mMutex;
+  std::condition_variable mWake;
+  std::deque<Job> mJobs;
+  std::vector<std::thread> mWorkers;
+  bool mStopping;
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <atomic>
+
+// Hands values from one writer thread to one reader thread without either
+// ever waiting on the other.
+//
+// The writer fills Back() and Publish()es it, the reader calls Update() and
+// reads Front(). There are three slots: the one being written, the one
+// being read, and the most recently published one in between. Publishing
+// and updating just swap a slot with the middle one, so the reader always
+// gets the newest finished value and older ones are simply overwritten.
+template <typename T>
+class TripleBuffer
+{
+public:
+  // Writer only.
+  T& Back()
+  {
+    return mSlots[mBack];
+  }
+
+  void Publish()
+  {
+    mBack = mMiddle.exchange(mBack | cFresh, std::memory_order_acq_rel) & cIndex;
+  }
+
+  // Reader only. Swaps in the newest published value, returns false if
+  // nothing has been published since the last call.
+  bool Update()
+  {
+    if (0 == (mMiddle.load(std::memory_order_relaxed) & cFresh))
+    {
+      return false;
+    }
+
+    mFront = mMiddle.exchange(mFront, std::memory_order_acq_rel) & cIndex;
+    return true;
+  }
+
+  const T& Front() const
+  {
+    return mSlots[mFront];
+  }
+
+private:
+  static constexpr unsigned cIndex = 0x3;
+  static constexpr unsigned cFresh = 0x4;
+
+  T mSlots[3];
+  unsigned mFront{ 0 };
+  std::atomic<unsigned> mMiddle{ 1 };
+  unsigned mBack{ 2 };
+};
@@ -7,6 +7,8 @@
 #define Utilities_hpp
 
 #include <cstdint>
+#include <cstdio>
+#include <cstdlib>
 
 #include <memory>
 #include <string>
@@ -14,6 +16,16 @@
 
 using byte = std::uint8_t;
 
+// Unlike assert, this is kept in release builds.
+inline void runtime_assert(bool aCondition, const char *aMessage)
+{
+  if (false == aCondition)
+  {
+    std::fprintf(stderr, "%s\n", aMessage);
+    std::abort();
+  }
+}
+
 using s8 = signed char;
 using s16 = signed short;
 using s32 = signed int;
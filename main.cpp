@@ -5,6 +5,7 @@
 #include "imgui.h"
 #include "imgui_impl_glfw_gl3.h"
 
+#include <algorithm>
 #include <map>
 #include <chrono>
 
@@ -18,6 +19,14 @@
 
 #include "Rendering.hpp"
 #include "Projects.hpp"
+#include "CurveMath.hpp"
+#include "Headless.hpp"
+#include "Profiler.hpp"
+
+// Most control points the sliders allow. Free points aren't edited with
+// sliders, so there can be far more of them.
+constexpr int cMaxFunctionPoints = 1000;
+constexpr int cMaxFreePoints = 10000;
 
 static void error_callback(int error, const char* description)
 {
@@ -46,39 +55,86 @@ void OptionsWindow(Project &aProject)
     aProject.mPosition = { 5.24f, 0.0f, 7.39f };
   }
 
-  ImGui::SliderInt("Control Points", &aProject.mControlPoints, 2, 21);
+#if MAT300_PROFILE
+  bool tracing = Profiler::Get().IsTracing();
+
+  if (ImGui::Checkbox("Record Trace", &tracing))
+  {
+    if (tracing)
+    {
+      Profiler::Get().BeginTrace("MAT300Trace.json");
+    }
+    else
+    {
+      Profiler::Get().EndTrace();
+    }
+  }
+
+  ImGui::SameLine(); ShowHelpMarker("Writes MAT300Trace.json, open it in chrome://tracing or ui.perfetto.dev.");
+#endif
+
+  ImGui::Checkbox("Evaluate in Background", &aProject.mAsyncEvaluation);
+  ImGui::SameLine(); ShowHelpMarker("Evaluates curves on worker threads, the last finished curve is drawn until the next one is ready.");
+
+  ImGui::SliderInt("Control Points", &aProject.mControlPoints, 2, aProject.mFreePlacement ? cMaxFreePoints : cMaxFunctionPoints);
   ImGui::SameLine(); ShowHelpMarker("or, d + 1");
 
   if (aProject.mControlPoints != static_cast<int>(aProject.mPoints.size()))
   {
     aProject.mPoints.clear();
     aProject.mPoints.resize(aProject.mControlPoints, 1.0f);
+    aProject.PointsChanged();
   }
 
-  for (auto[point, i] : enumerate(aProject.mPoints))
+  // Free points are dragged around in the view instead.
+  if (false == aProject.mFreePlacement)
   {
-    int d = static_cast<int>(i);
-    ImGui::PushID(d);
-    ImGui::VSliderFloat("##v", ImVec2(10, 160), &(*point), -3.0f, 3.0f, "");
-    
-    if (ImGui::IsItemActive() || ImGui::IsItemHovered())
+    for (auto[point, i] : enumerate(aProject.mPoints))
     {
-      ImGui::SetTooltip("Control Point %d, at y = %f", d, *point);
-    }
+      int d = static_cast<int>(i);
+      ImGui::PushID(d);
+      if (ImGui::VSliderFloat("##v", ImVec2(10, 160), &(*point), -3.0f, 3.0f, ""))
+      {
+        aProject.PointsChanged();
+      }
+      
+      if (ImGui::IsItemActive() || ImGui::IsItemHovered())
+      {
+        ImGui::SetTooltip("Control Point %d, at y = %f", d, *point);
+      }
 
-    if (i != (aProject.mPoints.size() - 1))
-    {
-      ImGui::SameLine();
-    }
+      if (i != (aProject.mPoints.size() - 1))
+      {
+        ImGui::SameLine();
+      }
 
-    ImGui::PopID();
+      ImGui::PopID();
+    }
   }
 
   static int item{ 0 };
-  ImGui::Combo("Project", &item, aProject.mProjectNames.data(), static_cast<int>(aProject.mProjectNames.size()));
+  if (ImGui::Combo("Project", &item, aProject.mProjectNames.data(), static_cast<int>(aProject.mProjectNames.size())))
+  {
+    // The curve is only rebuilt when it changes, so don't leave the last
+    // project's curve lying around, and make sure the new one gets built.
+    aProject.mCurve.Clear();
+    aProject.mLines.Clear();
+    aProject.mPointXs.clear();
+    aProject.PointsChanged();
+
+    // Only free points go past the functions' limit.
+    if (aProject.mControlPoints > cMaxFunctionPoints)
+    {
+      aProject.mControlPoints = cMaxFunctionPoints;
+      aProject.mPoints.clear();
+      aProject.mPoints.resize(aProject.mControlPoints, 1.0f);
+    }
+  }
 
   if (-1 < item && static_cast<size_t>(item) < aProject.mProjectNames.size())
   {
+    PROFILE_SCOPE("Project");
+    aProject.mFreePlacement = false;
     aProject.aProjectFunctions[item].second(aProject);
   }
 
@@ -141,24 +197,11 @@ bool viewToWorldCoordTransform(Project &aProject, int aMouseX, int aMouseY, glm:
 
   glm::vec4 ray_clip = glm::vec4(glm::vec2(ray_nds.x, ray_nds.y), -1.0, 1.0);
 
-  
-
-  auto projection = glm::perspective(glm::radians(45.0f),
-                                     width / height,
-                                     0.1f,
-                                     100.0f);
-
-  glm::vec4 ray_eye = glm::inverse(projection) * ray_clip;
+  // Same camera the frame is drawn with, see Project::UpdateCamera.
+  glm::vec4 ray_eye = glm::inverse(aProject.ProjectionMatrix) * ray_clip;
   ray_eye = glm::vec4(glm::vec2(ray_eye.x, ray_eye.y), -1.0, 0.0);
 
-  
-
-  auto view = NicksViewMatrix({ 1.0f, 0.0f, 0.0f },
-                              { 0.0f, 1.0f, 0.0f }, 
-                              { 0.0f, 0.0f, -1.0f }, 
-                              aProject.mPosition);
-
-  glm::vec4 ray_wor4 = (glm::inverse(view) * ray_eye);
+  glm::vec4 ray_wor4 = (glm::inverse(aProject.ViewMatrix) * ray_eye);
   glm::vec3 ray_wor = { ray_wor4.x, ray_wor4.y , ray_wor4.z };
 
   // don't forget to normalize the vector at some point
@@ -171,35 +214,120 @@ bool viewToWorldCoordTransform(Project &aProject, int aMouseX, int aMouseY, glm:
 }
 
 
-float Vector2DDistance(glm::vec2 &pVec0, glm::vec2 &pVec1)
+bool gMouseDown{ false };
+int gSelectedPoint{ -1 };
+
+void HandleInput(GLFWwindow *aWindow, Project &aProject, float aDt)
 {
-  float deltaX = pVec0.x - pVec1.x;
-  float deltaY = pVec0.y - pVec1.y;
+  PROFILE_SCOPE("Input");
 
-  return (float)sqrt((deltaX * deltaX) + (deltaY * deltaY));
-}
+  float dx{ 0.0f };
+  float dy{ 0.0f };
+  float dz{ 0.0f };
 
+  constexpr float cameraMoveSpeed = 2.0f;
 
+  if (GLFW_PRESS == glfwGetKey(aWindow, GLFW_KEY_UP))
+  {
+    dy += aDt * 1.0f * cameraMoveSpeed;
+  }
+  if (GLFW_PRESS == glfwGetKey(aWindow, GLFW_KEY_DOWN))
+  {
+    dy -= aDt * 1.0f * cameraMoveSpeed;
+  }
+  if (GLFW_PRESS == glfwGetKey(aWindow, GLFW_KEY_RIGHT))
+  {
+    dx += aDt * 1.0f * cameraMoveSpeed;
+  }
+  if (GLFW_PRESS == glfwGetKey(aWindow, GLFW_KEY_LEFT))
+  {
+    dx -= aDt * 1.0f * cameraMoveSpeed;
+  }
+  if (GLFW_PRESS == glfwGetKey(aWindow, GLFW_KEY_PAGE_UP))
+  {
+    dz -= aDt * 1.0f * cameraMoveSpeed;
+  }
+  if (GLFW_PRESS == glfwGetKey(aWindow, GLFW_KEY_PAGE_DOWN))
+  {
+    dz += aDt * 1.0f * cameraMoveSpeed;
+  }
 
-bool StaticPointToStaticCircle(glm::vec2 &aP, glm::vec2 &aCenter, float Radius, float &distance)
-{
-  distance = Vector2DDistance(aP, aCenter);
-  if (Radius >= distance)
+  if (GLFW_PRESS == glfwGetMouseButton(aWindow, GLFW_MOUSE_BUTTON_1))
   {
-    return true;
+    double x, y;
+    glfwGetCursorPos(aWindow, &x, &y);
+
+    // Picking is all done on the CPU against the z = 0 plane, reading
+    // anything back from the framebuffer would stall on the GPU.
+    glm::vec3 intersection{};
+    auto success = viewToWorldCoordTransform(aProject, static_cast<int>(x), static_cast<int>(y), intersection);
+    if (success && false == gMouseDown)
+    {
+      // The points are drawn scaled by the axes, so undo that to get back
+      // to the space the control points live in.
+      glm::vec2 curveIntersection{ intersection.x / aProject.mXAxis.mScale.x,
+                                   intersection.y / aProject.mYAxis.mScale.y };
+
+      if (aProject.mFreePlacement)
+      {
+        gSelectedPoint = PickControlPoint(aProject.mFreePoints, curveIntersection, 0.06f);
+      }
+      else if (aProject.mPointXs.size() == aProject.mPoints.size())
+      {
+        gSelectedPoint = PickControlPoint(aProject.mPoints, aProject.mPointXs, curveIntersection, 0.06f);
+      }
+      else
+      {
+        gSelectedPoint = PickControlPoint(aProject.mPoints, curveIntersection, 0.06f);
+      }
+    }
+
+    if (gMouseDown && gSelectedPoint >= 0 && success)
+    {
+      glm::vec3 intersection2{};
+
+      //printf("x: %f, y: %f, z: %f\n",
+      //       intersection.x,
+      //       intersection.y,
+      //       intersection.z); 
+
+      if (aProject.mFreePlacement)
+      {
+        aProject.mFreePoints.mX[gSelectedPoint] = intersection.x / aProject.mXAxis.mScale.x;
+        aProject.mFreePoints.mY[gSelectedPoint] = intersection.y / aProject.mYAxis.mScale.y;
+      }
+      else
+      {
+        aProject.mPoints[gSelectedPoint] = intersection.y;
+      }
+
+      aProject.PointsChanged();
+    }
+
+
+    gMouseDown = true;
   }
   else
   {
-    return false;
+    gMouseDown = false;
+    gSelectedPoint = -1;
   }
-}
 
-bool gMouseDown{ false };
-int gSelectedPoint{ -1 };
+  aProject.mPosition.x += dx;
+  aProject.mPosition.y += dy;
+  aProject.mPosition.z += dz;
 
+  if (aProject.mPosition.z < 0.1f)
+  {
+    aProject.mPosition.z = 0.1f;
+  }
+}
 
-int main(int, char**)
+int main(int argc, char** argv)
 {
+  HeadlessOptions headlessOptions;
+  bool headless = ParseHeadlessOptions(argc, argv, headlessOptions);
+
   // Setup window
   glfwSetErrorCallback(error_callback);
   if (!glfwInit())
@@ -207,14 +335,26 @@ int main(int, char**)
     return 1;
   }
 
-  glfwWindowHint(GLFW_SAMPLES, 4);
+  // Headless runs draw offscreen, so the window only has to provide a
+  // context. Skipping multisampling keeps checksums stable across drivers.
+  glfwWindowHint(GLFW_SAMPLES, headless ? 0 : 4);
+  glfwWindowHint(GLFW_VISIBLE, headless ? GLFW_FALSE : GLFW_TRUE);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
   glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
   glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
   #if __APPLE__
   glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
   #endif
-  GLFWwindow* window = glfwCreateWindow(1280, 720, "ImGui OpenGL3 example", NULL, NULL);
+  GLFWwindow* window = headless
+    ? glfwCreateWindow(headlessOptions.mWidth, headlessOptions.mHeight, "MAT300 Headless", NULL, NULL)
+    : glfwCreateWindow(1280, 720, "ImGui OpenGL3 example", NULL, NULL);
+
+  if (nullptr == window)
+  {
+    glfwTerminate();
+    return 1;
+  }
+
   glfwMakeContextCurrent(window);
   gl3wInit();
 
@@ -229,164 +369,106 @@ int main(int, char**)
 
   // Setup ImGui binding
   ImGui_ImplGlfwGL3_Init(window, true);
-  
-  ImVec4 clear_color = ImColor(44, 44, 44);
-
-  Project project;
 
-  std::chrono::time_point<std::chrono::high_resolution_clock> mBegin = std::chrono::high_resolution_clock::now();
-  std::chrono::time_point<std::chrono::high_resolution_clock> mLastFrame = mBegin;
+  if (nullptr != headlessOptions.mTracePath &&
+      false == Profiler::Get().BeginTrace(headlessOptions.mTracePath))
+  {
+    fprintf(stderr, "Couldn't open %s to record a trace.\n", headlessOptions.mTracePath);
+  }
 
-  // Main loop
-  while (!glfwWindowShouldClose(window))
+  if (headless)
   {
-    std::chrono::duration<float> timeSpan =
-      std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::high_resolution_clock::now() - mLastFrame);
-    mLastFrame = std::chrono::high_resolution_clock::now();
+    auto result = RunHeadless(headlessOptions);
+    Profiler::Get().EndTrace();
+
+    ImGui_ImplGlfwGL3_Shutdown();
+    glfwTerminate();
+
+    return result;
+  }
+  
+  ImVec4 clear_color = ImColor(44, 44, 44);
 
-    //if (totalTime > PI)
-    //{
-    //  totalTime = 0.0f;
-    //}
+  // The project owns GL objects, so it has to be gone before the context is.
+  {
+    Project project;
 
-    float dt = timeSpan.count();
+    std::chrono::time_point<std::chrono::high_resolution_clock> mBegin = std::chrono::high_resolution_clock::now();
+    std::chrono::time_point<std::chrono::high_resolution_clock> mLastFrame = mBegin;
 
-    glfwPollEvents();
+    // Main loop
+    while (!glfwWindowShouldClose(window))
+    {
+      std::chrono::duration<float> timeSpan =
+        std::chrono::duration_cast<std::chrono::duration<float>>(std::chrono::high_resolution_clock::now() - mLastFrame);
+      mLastFrame = std::chrono::high_resolution_clock::now();
 
-    glfwGetWindowSize(window, &project.mWindowSize.x, &project.mWindowSize.y);
+      //if (totalTime > PI)
+      //{
+      //  totalTime = 0.0f;
+      //}
 
-    ImGui_ImplGlfwGL3_NewFrame();
+      float dt = timeSpan.count();
 
-    ImGui::SetNextWindowPos(ImVec2(350, 20), ImGuiSetCond_FirstUseEver);
+      glfwPollEvents();
 
-    OptionsWindow(project);
+      auto frameStart = std::chrono::high_resolution_clock::now();
 
-    float dx{ 0.0f };
-    float dy{ 0.0f };
-    float dz{ 0.0f };
+      glfwGetWindowSize(window, &project.mWindowSize.x, &project.mWindowSize.y);
+      project.UpdateCamera();
 
-    constexpr float cameraMoveSpeed = 2.0f;
+      ImGui_ImplGlfwGL3_NewFrame();
 
-    if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_UP))
-    {
-      dy += dt * 1.0f * cameraMoveSpeed;
-    }
-    if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_DOWN))
-    {
-      dy -= dt * 1.0f * cameraMoveSpeed;
-    }
-    if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_RIGHT))
-    {
-      dx += dt * 1.0f * cameraMoveSpeed;
-    }
-    if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_LEFT))
-    {
-      dx -= dt * 1.0f * cameraMoveSpeed;
-    }
-    if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_PAGE_UP))
-    {
-      dz -= dt * 1.0f * cameraMoveSpeed;
-    }
-    if (GLFW_PRESS == glfwGetKey(window, GLFW_KEY_PAGE_DOWN))
-    {
-      dz += dt * 1.0f * cameraMoveSpeed;
-    }
+      ImGui::SetNextWindowPos(ImVec2(350, 20), ImGuiSetCond_FirstUseEver);
 
-    if (GLFW_PRESS == glfwGetMouseButton(window, GLFW_MOUSE_BUTTON_1))
-    {
-      double x, y;
-      glfwGetCursorPos(window, &x, &y);
-
-      float pixelData[4];
-
-      glReadPixels(static_cast<int>(x), 
-                   project.mWindowSize.y -  static_cast<int>(y), 
-                   1, 
-                   1, 
-                   GL_RGBA, 
-                   GL_FLOAT, 
-                   pixelData);
-
-      glm::vec4 pixel;
-      pixel.x = pixelData[0];
-      pixel.y = pixelData[1];
-      pixel.z = pixelData[2];
-      pixel.a = pixelData[3];
-
-      glm::vec3 intersection{};
-      auto success = viewToWorldCoordTransform(project, static_cast<int>(x), static_cast<int>(y), intersection);
-      if (success && false == gMouseDown)
       {
-        glm::vec3 scale = { 1.0f / project.mXAxis.mScale.x,
-                            1.0f / project.mYAxis.mScale.y,
-                            1.0f / project.mZAxis.mScale.z };
-
-        glm::mat4 model{};
-        model = glm::scale(model, scale);
-
-        float lowestDistance = std::numeric_limits<float>::max();
-        for (size_t i{ 0 }; i < project.mPointDrawer.mVertices.size(); ++i)
-        {
-          glm::vec2 point{ project.mPointDrawer.mVertices[i].mPosition.x, 
-                           project.mPointDrawer.mVertices[i].mPosition.y };
-
-          auto scaledIntersection = model * glm::vec4{ intersection, 1.0f };
-
-          glm::vec2 intersection2D{ scaledIntersection.x, scaledIntersection.y };
-          float distance;
-          
-          if (StaticPointToStaticCircle(intersection2D, point, 0.06f, distance) && distance < lowestDistance)
-          {
-            lowestDistance = distance;
-            gSelectedPoint = static_cast<int>(i);
-          }
-        }
+        PROFILE_SCOPE("Options Window");
+        OptionsWindow(project);
       }
 
-      if (gMouseDown && gSelectedPoint >= 0 && success)
-      {
-        glm::vec3 intersection2{};
+      ProfilerWindow();
 
-        //printf("x: %f, y: %f, z: %f\n",
-        //       intersection.x,
-        //       intersection.y,
-        //       intersection.z); 
+      HandleInput(window, project, dt);
 
-        project.mPoints[gSelectedPoint] = intersection.y;
-      }
+      // Rendering
+      int display_w, display_h;
+      glfwGetFramebufferSize(window, &display_w, &display_h);
+      glViewport(0, 0, display_w, display_h);
+      glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
+      glClear(GL_COLOR_BUFFER_BIT);
 
+      project.RenderAxis();
 
-      gMouseDown = true;
-    }
-    else
-    {
-      gMouseDown = false;
-      gSelectedPoint = -1;
-    }
+      {
+        PROFILE_SCOPE("ImGui Render");
+        ImGui::Render();
+      }
 
-    project.mPosition.x += dx;
-    project.mPosition.y += dy;
-    project.mPosition.z += dz;
+  #if MAT300_PROFILE
+      // Dragging gets its own line, since that's the latency you actually feel.
+      static const size_t frameStage = Profiler::Get().StageIndex("Frame (CPU)");
+      static const size_t dragStage = Profiler::Get().StageIndex("Frame (CPU, Dragging)");
 
-    if (project.mPosition.z < 0.1f)
-    {
-      project.mPosition.z = 0.1f;
-    }
+      auto frameEnd = std::chrono::high_resolution_clock::now();
+      Profiler::Get().Record(frameStage, frameStart, frameEnd);
 
-    // Rendering
-    int display_w, display_h;
-    glfwGetFramebufferSize(window, &display_w, &display_h);
-    glViewport(0, 0, display_w, display_h);
-    glClearColor(clear_color.x, clear_color.y, clear_color.z, clear_color.w);
-    glClear(GL_COLOR_BUFFER_BIT);
+      if (0 <= gSelectedPoint)
+      {
+        Profiler::Get().Record(dragStage, frameStart, frameEnd);
+      }
+  #endif
 
-    project.RenderAxis();
+      {
+        PROFILE_SCOPE("Swap Buffers");
+        glfwSwapBuffers(window);
+      }
 
-    ImGui::Render();
-    glfwSwapBuffers(window);
+      Profiler::Get().EndFrame();
+    }
   }
 
   // Cleanup
+  Profiler::Get().EndTrace();
   ImGui_ImplGlfwGL3_Shutdown();
   glfwTerminate();
 